@@ -0,0 +1,165 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Branch-free audio kernels for NinjamClientService::processSubBlock.
+// Each output kernel is specialised on channel count, whether the output
+// phase ring is read (host-locked) or NJClient output is used directly
+// (fallback), and the monitor mode. The service picks one through
+// selectOutputKernel() when its configuration changes, so the per-block
+// path carries no mode tests.
+namespace AudioKernels
+{
+// Matches NinjamClientService::MonitorMode.
+enum MonitorModeIndex
+{
+  monitorIncomingOnly = 0,
+  monitorAddLocal = 1,
+  monitorListenLocal = 2
+};
+
+// Splits a copy between two rings into contiguous spans (at most three when
+// both sides wrap) so each span can go through FloatVectorOperations. An
+// empty copy returns before the positions are wrapped: either length may
+// be zero then (an empty host block).
+template <typename SpanFn>
+void forEachRingSpan(int dstPos, int dstLen, int srcPos, int srcLen, int numSamples, SpanFn&& fn)
+{
+  if (numSamples <= 0)
+    return;
+
+  jassert(numSamples <= dstLen && numSamples <= srcLen);
+  dstPos = ((dstPos % dstLen) + dstLen) % dstLen;
+  srcPos = ((srcPos % srcLen) + srcLen) % srcLen;
+
+  while (numSamples > 0)
+  {
+    const int spanLen = juce::jmin(numSamples, dstLen - dstPos, srcLen - srcPos);
+    fn(dstPos, srcPos, spanLen);
+
+    numSamples -= spanLen;
+    dstPos += spanLen;
+    srcPos += spanLen;
+    if (dstPos == dstLen) dstPos = 0;
+    if (srcPos == srcLen) srcPos = 0;
+  }
+}
+
+// Splits a host block longer than maxSubBlock for processSubBlock: pieces
+// of at most maxSubBlock samples that also end on NJClient interval
+// boundaries. getPosition(pos, len) reports the server position before
+// each piece, after the previous one has advanced it.
+template <typename PositionFn, typename SubBlockFn>
+void forEachSubBlock(int numSamples, int maxSubBlock, PositionFn&& getPosition, SubBlockFn&& fn)
+{
+  for (int offset = 0; offset < numSamples;)
+  {
+    int intervalPos = 0, intervalLen = 0;
+    getPosition(intervalPos, intervalLen);
+
+    int len = juce::jmin(maxSubBlock, numSamples - offset);
+    if (intervalLen > 0 && intervalPos >= 0 && intervalPos < intervalLen)
+      len = juce::jmin(len, intervalLen - intervalPos);
+
+    fn(offset, len);
+    offset += len;
+  }
+}
+
+struct OutputArgs
+{
+  float* const* host = nullptr;          // input on entry, output on exit
+  const float* const* remote = nullptr;  // NJClient output (fallback)
+  const float* const* ring = nullptr;    // output phase ring (host-locked)
+  int ringPos = 0;
+  int ringLen = 0;
+  int numSamples = 0;
+  float localGain = 1.0f;
+  float remoteGain = 1.0f;
+};
+
+using OutputKernel = void (*)(const OutputArgs&);
+
+// The vector operations every kernel is built from. Tests instantiate the
+// kernels with a counting stand-in to measure the passes they make.
+struct VectorOps
+{
+  static void multiply(float* dst, float gain, int numSamples) noexcept
+  {
+    juce::FloatVectorOperations::multiply(dst, gain, numSamples);
+  }
+
+  static void copyWithMultiply(float* dst, const float* src, float gain, int numSamples) noexcept
+  {
+    juce::FloatVectorOperations::copyWithMultiply(dst, src, gain, numSamples);
+  }
+
+  static void addWithMultiply(float* dst, const float* src, float gain, int numSamples) noexcept
+  {
+    juce::FloatVectorOperations::addWithMultiply(dst, src, gain, numSamples);
+  }
+};
+
+template <int NumChannels, bool Add, typename Ops = VectorOps>
+void mixRemote(float* const* dst, const float* const* src, int numSamples, float gain)
+{
+  for (int ch = 0; ch < NumChannels; ++ch)
+  {
+    if constexpr (Add)
+      Ops::addWithMultiply(dst[ch], src[ch], gain, numSamples);
+    else
+      Ops::copyWithMultiply(dst[ch], src[ch], gain, numSamples);
+  }
+}
+
+template <int NumChannels, bool Add, typename Ops = VectorOps>
+void mixRing(float* const* dst, const float* const* ring, int ringPos, int ringLen, int numSamples, float gain)
+{
+  forEachRingSpan(0, numSamples, ringPos, ringLen, numSamples, [&](int dstStart, int srcStart, int spanLen)
+  {
+    for (int ch = 0; ch < NumChannels; ++ch)
+    {
+      if constexpr (Add)
+        Ops::addWithMultiply(dst[ch] + dstStart, ring[ch] + srcStart, gain, spanLen);
+      else
+        Ops::copyWithMultiply(dst[ch] + dstStart, ring[ch] + srcStart, gain, spanLen);
+    }
+  });
+}
+
+template <int NumChannels, bool ReadRing, int Mode, typename Ops = VectorOps>
+void writeOutput(const OutputArgs& args)
+{
+  constexpr bool scaleLocal = (Mode == monitorAddLocal || Mode == monitorListenLocal);
+  constexpr bool addRemote = (Mode == monitorAddLocal);
+
+  if constexpr (scaleLocal)
+  {
+    if (args.localGain != 1.0f)
+    {
+      for (int ch = 0; ch < NumChannels; ++ch)
+        Ops::multiply(args.host[ch], args.localGain, args.numSamples);
+    }
+  }
+
+  if constexpr (Mode != monitorListenLocal)
+  {
+    if constexpr (ReadRing)
+      mixRing<NumChannels, addRemote, Ops>(args.host, args.ring, args.ringPos, args.ringLen, args.numSamples, args.remoteGain);
+    else
+      mixRemote<NumChannels, addRemote, Ops>(args.host, args.remote, args.numSamples, args.remoteGain);
+  }
+}
+
+inline OutputKernel selectOutputKernel(int numChannels, bool readRing, int monitorMode)
+{
+  static constexpr OutputKernel table[2][2][3] = {
+    { { &writeOutput<1, false, monitorIncomingOnly>, &writeOutput<1, false, monitorAddLocal>, &writeOutput<1, false, monitorListenLocal> },
+      { &writeOutput<1, true, monitorIncomingOnly>,  &writeOutput<1, true, monitorAddLocal>,  &writeOutput<1, true, monitorListenLocal> } },
+    { { &writeOutput<2, false, monitorIncomingOnly>, &writeOutput<2, false, monitorAddLocal>, &writeOutput<2, false, monitorListenLocal> },
+      { &writeOutput<2, true, monitorIncomingOnly>,  &writeOutput<2, true, monitorAddLocal>,  &writeOutput<2, true, monitorListenLocal> } }
+  };
+
+  return table[juce::jlimit(1, 2, numChannels) - 1][readRing ? 1 : 0][juce::jlimit(0, 2, monitorMode)];
+}
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Interval-length ring storage for the phase and input rings. Samples are
+// kept as float, or in compact mode as int16 with 12 dB of headroom (a mix
+// of remote users can exceed full scale), which halves the memory of
+// long-interval rooms. Storage is sized once by allocate() for the longest
+// allowed interval; the audio thread only moves the logical length within
+// it, so nothing here allocates after allocate().
+class IntervalRing
+{
+public:
+  void allocate(int channels, int capacitySamples, bool useCompactStorage)
+  {
+    numChannels = channels;
+    capacity = capacitySamples;
+    compact = useCompactStorage;
+    length = 0;
+    fill = {};
+
+    if (compact)
+    {
+      floatSamples.setSize(0, 0);
+      compactSamples.assign(static_cast<size_t>(channels) * static_cast<size_t>(capacitySamples), 0);
+    }
+    else
+    {
+      compactSamples.clear();
+      compactSamples.shrink_to_fit();
+      floatSamples.setSize(channels, capacitySamples, false, true, false);
+    }
+  }
+
+  int getNumChannels() const noexcept { return numChannels; }
+  int getCapacity() const noexcept { return capacity; }
+  bool isCompact() const noexcept { return compact; }
+
+  size_t getStorageBytes() const noexcept
+  {
+    const auto sampleBytes = compact ? sizeof(int16_t) : sizeof(float);
+    return static_cast<size_t>(numChannels) * static_cast<size_t>(capacity) * sampleBytes;
+  }
+
+  int getLength() const noexcept { return length; }
+  int getFilledSamples() const noexcept { return fill.filled; }
+
+  // Nothing is cleared: the fill arc restarts, so every position, including
+  // any a longer interval newly exposes, reads as silence through
+  // clearUnwritten until it is rewritten.
+  void setLength(int newLength) noexcept
+  {
+    jassert(newLength <= capacity);
+    length = newLength;
+    fill = {};
+  }
+
+  // Forgets what has been written without clearing it (resync).
+  void restartFill() noexcept { fill = {}; }
+
+  void markWritten(int pos, int numSamples) noexcept
+  {
+    if (fill.filled >= length)
+      return;
+
+    pos = ((pos % length) + length) % length;
+
+    // Writes placed from the DAW phase can land a sample either side of the
+    // previous end; a real jump (seek) restarts the arc rather than vouching
+    // for the gap.
+    const int growth = ((pos + numSamples - fill.start - fill.filled) % length + length) % length;
+    if (fill.filled == 0 || growth > 2 * numSamples)
+    {
+      fill.start = pos;
+      fill.filled = juce::jmin(length, numSamples);
+      return;
+    }
+    fill.filled = juce::jmin(length, fill.filled + growth);
+  }
+
+  // Silences the part of [pos, pos + numSamples) outside the fill arc. The
+  // read span meets the unwritten arc at most twice: where it starts, and
+  // where it wraps round to the unwritten arc's start again.
+  void clearUnwritten(int pos, int numSamples, int numChannelsToClear) noexcept
+  {
+    // Only runs until the ring has been written once through after a resync.
+    if (fill.filled >= length)
+      return;
+
+    const int unwrittenStart = (fill.start + fill.filled) % length;
+    const int unwrittenLen = length - fill.filled;
+    const auto clearArc = [&](int arcStart, int arcLen)
+    {
+      AudioKernels::forEachRingSpan(arcStart, length, arcStart, length, arcLen, [&](int spanStart, int, int spanLen)
+      {
+        for (int ch = 0; ch < numChannelsToClear; ++ch)
+          clear(ch, spanStart, spanLen);
+      });
+    };
+
+    pos = ((pos % length) + length) % length;
+    const int offset = (pos - unwrittenStart + length) % length;
+    if (offset < unwrittenLen)
+      clearArc(pos, juce::jmin(numSamples, unwrittenLen - offset));
+
+    const int untilUnwrittenStart = length - offset;
+    if (untilUnwrittenStart < numSamples)
+      clearArc(unwrittenStart, juce::jmin(numSamples - untilUnwrittenStart, unwrittenLen));
+  }
+
+  // Copies between the ring, wrapping at its logical length, and a buffer
+  // that wraps at srcLen / dstLen.
+  void writeFrom(const juce::AudioBuffer<float>& src, int srcPos, int srcLen,
+                 int pos, int numChannelsToWrite, int numSamples) noexcept
+  {
+    AudioKernels::forEachRingSpan(pos, length, srcPos, srcLen, numSamples, [&](int ringStart, int srcStart, int spanLen)
+    {
+      for (int ch = 0; ch < numChannelsToWrite; ++ch)
+        write(ch, ringStart, src.getReadPointer(ch, srcStart), spanLen);
+    });
+  }
+
+  void readInto(juce::AudioBuffer<float>& dst, int dstPos, int dstLen,
+                int pos, int numChannelsToRead, int numSamples) const noexcept
+  {
+    AudioKernels::forEachRingSpan(dstPos, dstLen, pos, length, numSamples, [&](int dstStart, int ringStart, int spanLen)
+    {
+      for (int ch = 0; ch < numChannelsToRead; ++ch)
+        read(ch, ringStart, dst.getWritePointer(ch, dstStart), spanLen);
+    });
+  }
+
+  // Float storage only: the output kernels read it in place.
+  const float* getFloatPointer(int channel) const noexcept
+  {
+    jassert(!compact);
+    return floatSamples.getReadPointer(channel);
+  }
+
+  // Pack and unpack are plain loops over contiguous spans so the compiler
+  // vectorises them.
+  void write(int channel, int pos, const float* src, int numSamples) noexcept
+  {
+    if (!compact)
+    {
+      juce::FloatVectorOperations::copy(floatSamples.getWritePointer(channel, pos), src, numSamples);
+      return;
+    }
+
+    auto* dst = compactChannel(channel) + pos;
+    for (int i = 0; i < numSamples; ++i)
+    {
+      const float scaled = juce::jlimit(-32767.0f, 32767.0f, src[i] * packScale);
+      dst[i] = static_cast<int16_t>(scaled + std::copysign(0.5f, scaled));
+    }
+  }
+
+  void read(int channel, int pos, float* dst, int numSamples) const noexcept
+  {
+    if (!compact)
+    {
+      juce::FloatVectorOperations::copy(dst, floatSamples.getReadPointer(channel, pos), numSamples);
+      return;
+    }
+
+    const auto* src = compactChannel(channel) + pos;
+    for (int i = 0; i < numSamples; ++i)
+      dst[i] = static_cast<float>(src[i]) * unpackScale;
+  }
+
+  void clear(int channel, int pos, int numSamples) noexcept
+  {
+    if (!compact)
+    {
+      floatSamples.clear(channel, pos, numSamples);
+      return;
+    }
+
+    auto* dst = compactChannel(channel) + pos;
+    std::fill(dst, dst + numSamples, static_cast<int16_t>(0));
+  }
+
+private:
+  static constexpr float headroom = 4.0f; // +12 dB above full scale
+  static constexpr float packScale = 32767.0f / headroom;
+  static constexpr float unpackScale = headroom / 32767.0f;
+
+  int16_t* compactChannel(int channel) noexcept
+  {
+    return compactSamples.data() + static_cast<size_t>(channel) * static_cast<size_t>(capacity);
+  }
+
+  const int16_t* compactChannel(int channel) const noexcept
+  {
+    return compactSamples.data() + static_cast<size_t>(channel) * static_cast<size_t>(capacity);
+  }
+
+  // The arc written since the geometry last changed; anything outside it
+  // is stale and reads as silence.
+  struct Fill
+  {
+    int start = 0;
+    int filled = 0;
+  };
+
+  juce::AudioBuffer<float> floatSamples;
+  std::vector<int16_t> compactSamples;
+  int numChannels = 0;
+  int capacity = 0;
+  int length = 0;
+  Fill fill;
+  bool compact = false;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Peak meter written by the audio thread only; readers never block. A
+// reader polls getSequence() and only calls read() when it has moved, so a
+// meter that stops being published can be decayed on the reader's side.
+struct MeterSlot
+{
+  void publish(float value) noexcept
+  {
+    level.store(value, std::memory_order_relaxed);
+    sequence.fetch_add(1, std::memory_order_release);
+  }
+
+  float read() const noexcept { return level.load(std::memory_order_relaxed); }
+  uint32_t getSequence() const noexcept { return sequence.load(std::memory_order_acquire); }
+
+  std::atomic<float> level { 0.0f };
+  std::atomic<uint32_t> sequence { 0 };
+};
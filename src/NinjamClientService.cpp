@@ -1,11 +1,57 @@
 #include "NinjamClientService.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <limits>
 
 namespace
 {
 constexpr int kTimerHz = 20;
+constexpr int kMaxRunIterations = 8;
+constexpr int kNetworkPollMsConnected = 5;
+constexpr int kNetworkPollMsIdle = 50;
+constexpr double kStatusRefreshSeconds = 0.05;
+constexpr double kNetworkMetricsWindowSeconds = 1.0;
+constexpr int kEncodeWakeSamples = 1024;
+constexpr int kMaxAudioChannels = 2;
+constexpr int kMaxInputChannels = 8;
+constexpr int kStemChannels = 2;
+constexpr int kVoiceChannels = 2;
+constexpr int kVoiceChatFlag = 2;
+constexpr int kStereoSourceFlag = 1024; // NJClient srcch: stereo pair from the low bits
+constexpr int kMaxLocalSends = 3;
+constexpr int kMinSendBitrateKbps = 32;
+constexpr int kMaxSendBitrateKbps = 256;
+constexpr int kTalkbackLocalChannel = kMaxLocalSends + 1;
+constexpr int kTalkbackInputIndex = kMaxInputChannels;
+constexpr int kTalkbackBitrateKbps = 64;
+constexpr int kRingLimitMinBpm = 20;
+constexpr int kRingLimitMaxBpi = 256;
+constexpr double kMaxCustomClickSeconds = 0.5;
+constexpr double kAudioProcBudgetFraction = 0.5;
+constexpr int kMaxSubBlockSamples = 1024;
+constexpr double kDirectAlignToleranceMs = 1.0;
+constexpr double kHostClockToleranceSamples = 1.0;
+constexpr double kIntervalStallSeconds = 1.0;
+constexpr int kEstimatedRemoteChannelKbps = 96;
+constexpr int kInitialPrebufferBytes = 4096;
+constexpr int kMinPrebufferBytes = 1024;
+constexpr int kMaxPrebufferBytes = 32768;
+constexpr double kLateStartMs = 100.0;
+constexpr double kPlayedIntoWrapMs = 150.0;
+constexpr double kMaxDropoutMs = 500.0;
+constexpr double kTargetLateStartRate = 0.02;
+constexpr double kTargetDropoutRate = 0.02;
+constexpr int kJitterWindowStarts = 32;
+constexpr int kJitterFastReactEvents = 3;
+constexpr float kSilentIntervalPeak = 1.0e-4f; // -80 dB
+constexpr int kBitrateLadderKbps[] = { 32, 48, 64, 80, 96, 128, 160, 192, 256 };
+constexpr double kEncodeOverloadMarginFraction = 0.5;
+constexpr double kEncodeOverloadBacklogSeconds = 0.25;
+constexpr int kBitrateStepUpIntervals = 4;
+constexpr size_t kMaxBitrateHistory = 64;
+constexpr int kDefaultSendBitrateKbps = 96;
 constexpr int kMaxLogLines = 300;
 constexpr float kRemoteMeterDecay = 0.92f;
 constexpr float kGainMaxLinear = 3.1622777f; // +10 dB
@@ -23,6 +69,7 @@ enum SyncMode
 // ─────────────────────────────────────────────────────────────────────────────
 
 NinjamClientService::NinjamClientService()
+  : juce::Thread("NINJAM network")
 {
   state.statusText = statusCodeToText(NJClient::NJC_STATUS_DISCONNECTED);
   state.bpm = 120;
@@ -32,11 +79,13 @@ NinjamClientService::NinjamClientService()
   client.ChatMessage_Callback = &NinjamClientService::chatMessageCallback;
   client.LicenseAgreement_User = this;
   client.LicenseAgreementCallback = &NinjamClientService::licenseAgreementCallback;
-  client.config_autosubscribe = 1;
+  // Subscriptions are driven by applySubscriptionPolicy().
+  client.config_autosubscribe = 0;
   client.config_savelocalaudio = 0;
-  client.config_play_prebuffer = 4096;
+  client.config_play_prebuffer = kInitialPrebufferBytes;
   client.config_metronome_mute = false;
-  client.SetLocalChannelInfo(0, "Me", true, 0, true, 96, true, true);
+  client.SetLocalChannelInfo(0, "Me", true, 0, true, kDefaultSendBitrateKbps, true, true);
+  configuredSendBitrates[0] = kDefaultSendBitrateKbps;
   applySessionChannelModeToCore();
   // Keep NJClient local monitor muted; plugin handles Add/Listen monitoring.
   client.SetLocalChannelMonitoring(0, true, 1.0f, true, 0.0f, true, true, true, false);
@@ -44,13 +93,18 @@ NinjamClientService::NinjamClientService()
   configureCorePaths();
   addLogLine("Service initialized");
   startTimerHz(kTimerHz);
+  startThread(juce::Thread::Priority::high);
 }
 
 NinjamClientService::~NinjamClientService()
 {
   stopTimer();
+  signalThreadShouldExit();
+  networkWakeEvent.signal();
+  stopThread(2000);
+
   client.Disconnect();
-  for (int i = 0; i < 8; ++i)
+  for (int i = 0; i < kMaxRunIterations; ++i)
   {
     if (client.Run())
       break;
@@ -88,41 +142,43 @@ void NinjamClientService::connect()
     return;
   }
 
-  client.Connect(host.toRawUTF8(), user.toRawUTF8(), password.toRawUTF8());
+  {
+    const juce::ScopedLock clientScope(clientLock);
+    client.Connect(host.toRawUTF8(), user.toRawUTF8(), password.toRawUTF8());
+  }
+  networkWakeEvent.signal();
+
+  syncResetPending.store(true);
 
   {
     const juce::ScopedLock scopedLock(lock);
     state.intervalProgress = 0.0f;
     state.statusText = "Connecting...";
-    hostPhaseAccumulatorValid = false;
-    hostPhaseAccumulatorBeats = 0.0;
-    lastHostPhaseBeat = 0.0;
     appendLogLineUnlocked("Connecting to " + host + " as " + user);
   }
 }
 
 void NinjamClientService::disconnect()
 {
-  client.Disconnect();
+  {
+    const juce::ScopedLock clientScope(clientLock);
+    client.Disconnect();
+  }
+
+  // Audio-thread sync state is reset by the audio thread itself on its next block.
+  lastHostPpqValid.store(false);
+  lastHostBpmValid.store(false);
+  hostLockedActive.store(false);
+  forceSeekPending.store(false);
+  publishedSyncMode.store(-1);
+  syncResetPending.store(true);
 
   const juce::ScopedLock scopedLock(lock);
   state.connected = false;
   state.statusText = statusCodeToText(NJClient::NJC_STATUS_DISCONNECTED);
-  state.syncStateText = "Classic";
   state.intervalProgress = 0.0f;
-  lastHostPpqValid = false;
-  lastHostBpmValid = false;
-  hostLockedActive = false;
-  lastSyncMode = -1;
-  forceSeekPending = false;
   lastServerBpm = 0;
   lastServerBpi = 0;
-  hostPhaseAccumulatorValid = false;
-  hostPhaseAccumulatorBeats = 0.0;
-  lastHostPhaseBeat = 0.0;
-  phaseRingOffsetValid = false;
-  phaseRingBeatOffset = 0.0;
-  inputRingIntervalLen = 0;
   appendLogLineUnlocked("Disconnected from server");
 }
 
@@ -136,29 +192,35 @@ void NinjamClientService::sendCommand(const juce::String& text)
   if (trimmed.isEmpty())
     return;
 
-  const juce::ScopedLock scopedLock(lock);
-  appendLogLineUnlocked("> " + trimmed);
-
-  if (!state.connected)
   {
-    appendLogLineUnlocked("Not connected");
-    return;
+    const juce::ScopedLock scopedLock(lock);
+    appendLogLineUnlocked("> " + trimmed);
+
+    if (!state.connected)
+    {
+      appendLogLineUnlocked("Not connected");
+      return;
+    }
   }
 
+  juce::String messageType = "MSG";
+  juce::String payload = trimmed;
   if (trimmed.startsWithChar('/'))
   {
-    const auto adminCommand = trimmed.substring(1).trim();
-    if (adminCommand.isNotEmpty())
-    {
-      client.ChatMessage_Send("ADMIN", adminCommand.toRawUTF8());
-      appendLogLineUnlocked("ADMIN " + adminCommand);
-    }
+    messageType = "ADMIN";
+    payload = trimmed.substring(1).trim();
+    if (payload.isEmpty())
+      return;
   }
-  else
+
   {
-    client.ChatMessage_Send("MSG", trimmed.toRawUTF8());
-    appendLogLineUnlocked("MSG " + trimmed);
+    const juce::ScopedLock clientScope(clientLock);
+    client.ChatMessage_Send(messageType.toRawUTF8(), payload.toRawUTF8());
   }
+  networkWakeEvent.signal();
+
+  const juce::ScopedLock scopedLock(lock);
+  appendLogLineUnlocked(messageType + " " + payload);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -167,501 +229,1573 @@ void NinjamClientService::sendCommand(const juce::String& text)
 
 void NinjamClientService::processAudioBlock(juce::AudioBuffer<float>& buffer, const TransportState& transportState)
 {
-  const auto numChannels = juce::jmax(1, juce::jmin(2, buffer.getNumChannels()));
+  // Host blocks up to the sub-block size go straight through. Larger ones
+  // (offline renders, hosts exceeding their announced maximum) are split
+  // so sync, the rings and the metronome always see blocks shorter than an
+  // interval and no scratch buffer has to grow on the audio thread. Split
+  // points also land on NJClient interval boundaries.
+  const int numSamples = buffer.getNumSamples();
+  if (numSamples == 0)
+    return;
+
+  if (numSamples <= maxSubBlockSamples)
+  {
+    processSubBlock(buffer, transportState);
+    return;
+  }
+
+  const double rate = static_cast<double>(juce::jmax(1, sampleRate.load(std::memory_order_relaxed)));
+  const auto getPosition = [this](int& serverPos, int& intervalLen) { client.GetPosition(&serverPos, &intervalLen); };
+  AudioKernels::forEachSubBlock(numSamples, maxSubBlockSamples, getPosition, [&](int offset, int len)
+  {
+    TransportState subState = transportState;
+    subState.isSeek = transportState.isSeek && offset == 0;
+    if (transportState.isPlaying && transportState.hostTimeSeconds >= 0.0)
+    {
+      const double offsetSeconds = static_cast<double>(offset) / rate;
+      subState.hostTimeSeconds += offsetSeconds;
+      if (transportState.hostPpqValid && transportState.hostBpmValid)
+        subState.hostPpqPosition += offsetSeconds * transportState.hostBpm / 60.0;
+    }
+
+    juce::AudioBuffer<float> subBuffer(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), offset, len);
+    processSubBlock(subBuffer, subState);
+  });
+}
+
+void NinjamClientService::processSubBlock(juce::AudioBuffer<float>& buffer, const TransportState& transportState)
+{
+  const auto blockStartTicks = juce::Time::getHighResolutionTicks();
+  const auto numChannels = juce::jmax(1, juce::jmin(kMaxAudioChannels, hostMainChannels, buffer.getNumChannels()));
+  const auto numInputs = juce::jmax(numChannels, juce::jmin(kMaxInputChannels, hostInputChannels, buffer.getNumChannels()));
+  const auto numStems = numChannels == kMaxAudioChannels ? numStemOutputs : 0;
+  const auto numRingOutputs = numChannels + kStemChannels * numStems;
+  // Voice-chat channels land on a pair after the stems and bypass the
+  // phase ring; mono hosts get them through the main mix instead.
+  const bool voiceOutput = numChannels == kMaxAudioChannels;
+  const auto numOutputs = numRingOutputs + (voiceOutput ? kVoiceChannels : 0);
   const auto blockSize = buffer.getNumSamples();
+  const int currentSampleRate = sampleRate.load(std::memory_order_relaxed);
   const bool hasHostClock = transportState.hostTimeSeconds >= 0.0;
   const bool hasMusicalClock = transportState.hostBpmValid && transportState.hostPpqValid;
 
-  // ── Read shared state under lock ──
-  float localGainValue = 1.0f;
-  float remoteGainValue = 1.0f;
-  float phaseOffsetMsValue = 0.0f;
-  MonitorMode monitorMode = MonitorMode::IncomingOnly;
-  bool metronomeEnabled = true;
+  if (syncResetPending.exchange(false))
+    resetSyncStateForAudioThread();
+
+  // ── Read shared parameters (lock-free) ──
+  const float localGainValue = localGainParam.load(std::memory_order_relaxed);
+  const float remoteGainValue = remoteGainParam.load(std::memory_order_relaxed);
+  const float phaseOffsetMsValue = phaseOffsetMsParam.load(std::memory_order_relaxed);
+  const auto monitorMode = static_cast<MonitorMode>(monitorModeParam.load(std::memory_order_relaxed));
+  const bool metronomeEnabled = metronomeEnabledParam.load(std::memory_order_relaxed);
+  const auto alignmentMode = static_cast<AlignmentMode>(alignmentModeParam.load(std::memory_order_relaxed));
+  const int roomBpi = juce::jmax(1, roomBpiParam.load(std::memory_order_relaxed));
+  double sessionBpm = static_cast<double>(juce::jmax(1, sessionBpmParam.load(std::memory_order_relaxed)));
   int syncMode = syncFallbackNoClock;
   bool isPlaying = true;
   bool isSeek = false;
   double sessionPos = -1.0;
-  int roomBpi = 16;
-  double sessionBpm = 120.0;
   double rawDawPhase = -1.0;
 
+  lastHostPpq.store(transportState.hostPpqPosition, std::memory_order_relaxed);
+  lastHostPpqValid.store(transportState.hostPpqValid, std::memory_order_relaxed);
+  lastHostBpm.store(transportState.hostBpm, std::memory_order_relaxed);
+  lastHostBpmValid.store(transportState.hostBpmValid, std::memory_order_relaxed);
+
+  // ── Determine sync mode and compute phase ──
+  if (hasHostClock && transportState.isPlaying)
   {
-    const juce::ScopedLock scopedLock(lock);
-    localGainValue = state.localGain;
-    remoteGainValue = state.remoteGain;
-    phaseOffsetMsValue = state.phaseOffsetMs;
-    monitorMode = state.monitorMode;
-    metronomeEnabled = state.metronomeEnabled;
-    roomBpi = juce::jmax(1, state.bpi);
-    sessionBpm = static_cast<double>(juce::jmax(1, state.bpm));
-    lastHostPpq = transportState.hostPpqPosition;
-    lastHostPpqValid = transportState.hostPpqValid;
-    lastHostBpm = transportState.hostBpm;
-    lastHostBpmValid = transportState.hostBpmValid;
-
-    // ── Determine sync mode and compute phase ──
-    if (hasHostClock && transportState.isPlaying)
+    syncMode = syncHostLocked;
+    isPlaying = true;
+    isSeek = transportState.isSeek || !hostLockedActive.load(std::memory_order_relaxed);
+    if (forceSeekPending.exchange(false))
+      isSeek = true;
+
+    if (hasMusicalClock)
+      sessionBpm = transportState.hostBpm;
+
+    // Integer sample clock for NJClient's session position; the DAW phase
+    // is predicted from it and only re-anchored to the host on tempo
+    // changes and jumps (SampleClock::HostClock).
+    const double hostBeats = hasMusicalClock ? transportState.hostPpqPosition
+                                             : transportState.hostTimeSeconds * sessionBpm / 60.0;
+    const int safeRate = juce::jmax(currentSampleRate, 1);
+    const auto clock = hostClock.advance(hostBeats, sessionBpm, safeRate, roomBpi, blockSize,
+                                         isSeek, kHostClockToleranceSamples);
+    if (clock.restarted)
+    {
+      if (resyncElapsedSamples < 0)
+        resyncElapsedSamples = 0;
+      isSeek = true;
+    }
+
+    sessionPos = static_cast<double>(clock.sessionSamples) / static_cast<double>(safeRate);
+    rawDawPhase = clock.phaseBeats;
+  }
+  else if (hasHostClock)
+  {
+    syncMode = syncFallbackStopped;
+  }
+
+  if (syncMode != syncHostLocked)
+  {
+    isPlaying = true;
+    isSeek = false;
+    if (forceSeekPending.exchange(false))
+      isSeek = true;
+    if (isSeek)
+      hostClock.invalidate();
+    sessionPos = client.GetSessionPosition() / 1000.0;
+  }
+
+  hostLockedActive.store(syncMode == syncHostLocked, std::memory_order_relaxed);
+  if (syncMode != syncHostLocked)
+    resyncElapsedSamples = -1;
+
+  // ── Configure NJClient metronome ──
+  // When host-locked, we mute NJClient's metronome and render our own
+  // (phase-aligned to DAW beats). Otherwise let NJClient handle it.
+  const bool usePhaseRing = (syncMode == syncHostLocked);
+  if (usePhaseRing)
+  {
+    client.config_metronome_mute = true;
+  }
+  else
+  {
+    client.config_metronome_mute = !metronomeEnabled;
+  }
+
+  // ── Publish sync mode changes ──
+  if (syncMode != lastSyncMode)
+  {
+    publishedSyncMode.store(syncMode, std::memory_order_relaxed);
+    postEvent(ServiceEvent::Type::SyncModeChanged, syncMode);
+    lastSyncMode = syncMode;
+  }
+
+  const bool connected = client.GetStatus() == NJClient::NJC_STATUS_OK;
+
+  // Send level is measured on the raw input before anything touches it.
+  const float sendPeak = measurePeak(buffer, numChannels, blockSize);
+  sendMeterSlot.publish(clampMeter(sendPeak));
+
+  if (silenceGateEnabledParam.load(std::memory_order_relaxed))
+  {
+    float inputPeak = sendPeak;
+    for (int ch = numChannels; ch < numInputs; ++ch)
+    {
+      if (ch != talkbackSourceChannel)
+        inputPeak = juce::jmax(inputPeak, buffer.getMagnitude(ch, 0, blockSize));
+    }
+    if (inputPeak > silenceThresholdParam.load(std::memory_order_relaxed))
+      lastAudibleInputTicks.store(blockStartTicks, std::memory_order_relaxed);
+  }
+
+  float* hostBuffers[2] = { buffer.getWritePointer(0), nullptr };
+  hostBuffers[1] = numChannels > 1 ? buffer.getWritePointer(1) : hostBuffers[0];
+
+  // ── Disconnected: pass-through, no copies ──
+  if (!connected)
+  {
+    float outputPeak = sendPeak;
+    if (monitorMode == MonitorMode::ListenLocal)
+    {
+      AudioKernels::OutputArgs args;
+      args.host = hostBuffers;
+      args.numSamples = blockSize;
+      args.localGain = localGainValue;
+      selectOutputKernel(numChannels, false, monitorMode)(args);
+      outputPeak = sendPeak * localGainValue;
+    }
+    clearStemOutputs(buffer, numStems, blockSize);
+    localMeterSlot.publish(clampMeter(outputPeak));
+    publishRemoteMeter();
+    trackBlockTime(blockStartTicks);
+    return;
+  }
+
+  const int safeSampleRate = juce::jmax(currentSampleRate, 1);
+
+  if (outputScratch.getNumChannels() < numOutputs || outputScratch.getNumSamples() < blockSize)
+    outputScratch.setSize(numOutputs, blockSize, false, false, true);
+
+  // NJClient reads the host buffer directly unless the input ring remaps
+  // it. Send buses follow the main bus, so each local channel's source
+  // index is its channel in the host buffer.
+  float* inBuffers[kMaxInputChannels + 1] = {};
+  for (int ch = 0; ch < numInputs; ++ch)
+    inBuffers[ch] = buffer.getWritePointer(ch);
+
+  // Talkback reads its source unremapped from a fixed index past the
+  // regular inputs, so the input ring never delays it.
+  int numCoreInputs = numInputs;
+  if (talkbackSourceChannel >= 0 && talkbackSourceChannel < buffer.getNumChannels())
+  {
+    for (int ch = numInputs; ch < kTalkbackInputIndex; ++ch)
+      inBuffers[ch] = inBuffers[0];
+    inBuffers[kTalkbackInputIndex] = buffer.getWritePointer(talkbackSourceChannel);
+    numCoreInputs = kTalkbackInputIndex + 1;
+
+    auto expected = juce::int64 { 0 };
+    talkbackOldestUnsentTicks.compare_exchange_strong(expected, blockStartTicks, std::memory_order_relaxed);
+  }
+  float* outBuffers[kMaxAudioChannels + kStemChannels * maxStemOutputs + kVoiceChannels] = { outputScratch.getWritePointer(0), nullptr };
+  outBuffers[1] = numChannels > 1 ? outputScratch.getWritePointer(1) : outBuffers[0];
+  for (int ch = numChannels; ch < numOutputs; ++ch)
+    outBuffers[ch] = outputScratch.getWritePointer(ch);
+
+  // ── DIRECT ALIGNMENT: keep NJClient's own interval on the DAW beat grid ──
+  // Instead of remapping through the rings, NJClient's interval position is
+  // steered so it wraps on DAW beat 0 (plus the manual offset, which then
+  // applies to both directions). An error beyond the tolerance is corrected
+  // by the shorter way round: NJClient ahead is held still for the error,
+  // which gaps remote audio for that long; NJClient behind runs ahead on
+  // silence, which skips that much remote audio. Either way at most one
+  // block per callback, so a large error is spread over several callbacks
+  // rather than stalling or doubling the core's work for long in one. Only
+  // possible while the host tempo gives the same interval length as
+  // NJClient's.
+  bool directAligned = false;
+  bool directLocked = false;
+  int coreHoldSamples = 0;
+  int coreAdvanceSamples = 0;
+  if (usePhaseRing && alignmentMode == AlignmentMode::Direct)
+  {
+    int serverPos = 0, intervalLen = 0;
+    client.GetPosition(&serverPos, &intervalLen);
+    const double bpi = static_cast<double>(roomBpi);
+    const double hostIntervalLen = bpi * 60.0 / sessionBpm * static_cast<double>(safeSampleRate);
+
+    if (intervalLen > 0 && serverPos >= 0 && std::abs(hostIntervalLen - static_cast<double>(intervalLen)) <= 1.0)
     {
-      syncMode = syncHostLocked;
-      isPlaying = true;
-      isSeek = transportState.isSeek || !hostLockedActive;
-      if (forceSeekPending)
+      directAligned = true;
+
+      double dawBeat = std::fmod(rawDawPhase, bpi);
+      if (dawBeat < 0.0) dawBeat += bpi;
+      const int manualOffsetSamples = static_cast<int>(
+        static_cast<double>(phaseOffsetMsValue) * 0.001 * static_cast<double>(safeSampleRate));
+      const int targetPos = static_cast<int>(dawBeat / bpi * static_cast<double>(intervalLen)) + manualOffsetSamples;
+
+      // Positive: NJClient is ahead of the DAW grid.
+      int error = ((serverPos - targetPos) % intervalLen + intervalLen) % intervalLen;
+      if (error > intervalLen / 2)
+        error -= intervalLen;
+      alignmentErrorSamples.store(error, std::memory_order_relaxed);
+
+      const int tolerance = juce::jmax(1, static_cast<int>(kDirectAlignToleranceMs * 0.001 * static_cast<double>(safeSampleRate)));
+      if (directStallSamples == 0 && directAdvanceSamples == 0 && std::abs(error) > tolerance)
       {
-        isSeek = true;
-        forceSeekPending = false;
+        alignmentCorrections.fetch_add(1, std::memory_order_relaxed);
+        if (error > 0)
+          directStallSamples = error;
+        else
+          directAdvanceSamples = -error;
       }
 
-      if (hasMusicalClock)
-        sessionBpm = transportState.hostBpm;
+      coreHoldSamples = juce::jmin(directStallSamples, blockSize);
+      directStallSamples -= coreHoldSamples;
+      coreAdvanceSamples = juce::jmin(directAdvanceSamples, blockSize);
+      directAdvanceSamples -= coreAdvanceSamples;
+      directLocked = coreHoldSamples == 0 && directAdvanceSamples == 0;
+    }
+  }
 
-      // Compute cyclic DAW phase within BPI
-      const double bpiD = static_cast<double>(roomBpi);
-      double phaseBeat;
-      if (hasMusicalClock)
-        phaseBeat = std::fmod(transportState.hostPpqPosition, bpiD);
-      else
-        phaseBeat = std::fmod(transportState.hostTimeSeconds * sessionBpm / 60.0, bpiD);
-      if (phaseBeat < 0.0)
-        phaseBeat += bpiD;
+  // Leaving or entering direct alignment: the rings were not written while
+  // it was active, so whatever they hold is stale and they refill from
+  // empty, as after any other resync.
+  if (directAligned != lastDirectAligned)
+  {
+    lastDirectAligned = directAligned;
+    directAlignActive.store(directAligned, std::memory_order_relaxed);
+    directStallSamples = 0;
+    directAdvanceSamples = 0;
+    phaseRingBuffer.restartFill();
+    inputRingBuffer.restartFill();
+    for (int slot = 0; slot < numStems; ++slot)
+    {
+      if (stemRingReady[slot].load(std::memory_order_acquire))
+        stemRings[slot].restartFill();
+    }
+    if (usePhaseRing && resyncElapsedSamples < 0)
+      resyncElapsedSamples = 0;
+  }
 
-      // Smoothed phase accumulator for NJClient session position.
-      // Handles DAW PPQ wrapping at BPI boundaries by picking the
-      // delta candidate (raw, +cycle, -cycle) closest to expected advance.
-      const double beatsPerBlock = (static_cast<double>(blockSize) * sessionBpm) /
-                                   (60.0 * static_cast<double>(juce::jmax(sampleRate, 1)));
+  // ── INPUT RING: remap sender audio from DAW-beat → server-position order ──
+  // Ensures DAW beat 0 audio always lands at server interval position 0,
+  // so the receiver's output ring can map it back to their own beat 0.
+  if (usePhaseRing && !directAligned)
+  {
+    int serverPosBefore = 0, intervalLenBefore = 0;
+    client.GetPosition(&serverPosBefore, &intervalLenBefore);
+    if (serverPosBefore < 0) serverPosBefore = 0;
 
-      if (!hostPhaseAccumulatorValid || isSeek)
+    if (intervalLenBefore > 0 && intervalLenBefore >= blockSize && intervalLenBefore <= ringCapacity)
+    {
+      if (inputScratch.getNumChannels() < numInputs || inputScratch.getNumSamples() < blockSize)
+        inputScratch.setSize(numInputs, blockSize, false, false, true);
+
+      // Write at the DAW beat position, read at the server position.
+      const int writePos = PhaseRings::beatToPosition(rawDawPhase, roomBpi, intervalLenBefore);
+      PhaseRings::remapInput(inputRingBuffer, inputScratch, buffer, numInputs, blockSize,
+                             writePos, serverPosBefore, intervalLenBefore);
+      for (int ch = 0; ch < numInputs; ++ch)
+        inBuffers[ch] = inputScratch.getWritePointer(ch);
+      if (numCoreInputs > numInputs)
       {
-        hostPhaseAccumulatorValid = true;
-        hostPhaseAccumulatorBeats = phaseBeat;
-        lastHostPhaseBeat = phaseBeat;
-        isSeek = true;
+        for (int ch = numInputs; ch < kTalkbackInputIndex; ++ch)
+          inBuffers[ch] = inBuffers[0];
       }
-      else
+    }
+  }
+
+  // AudioProc zeroes its output buffers before mixing. Remote Vorbis
+  // decoding happens inside it, so its cost is tracked against a share of
+  // the block budget; overruns are reported rather than hidden.
+  const auto audioProcStartTicks = juce::Time::getHighResolutionTicks();
+  if (coreAdvanceSamples > 0)
+  {
+    // Run NJClient ahead on silence; the output is overwritten below.
+    if (inputScratch.getNumSamples() < blockSize)
+      inputScratch.setSize(juce::jmax(1, inputScratch.getNumChannels()), blockSize, false, false, true);
+    inputScratch.clear(0, 0, coreAdvanceSamples);
+    float* silentInputs[kMaxInputChannels + 1] = {};
+    for (int ch = 0; ch < numCoreInputs; ++ch)
+      silentInputs[ch] = inputScratch.getWritePointer(0);
+    client.AudioProc(silentInputs, numCoreInputs, outBuffers, numOutputs,
+                     coreAdvanceSamples, safeSampleRate, false, isPlaying, false, sessionPos);
+  }
+
+  const int coreSamples = blockSize - coreHoldSamples;
+  if (coreHoldSamples > 0)
+  {
+    // NJClient sits out the start of the block: its input is dropped and
+    // the held span plays no remote audio.
+    float* heldInputs[kMaxInputChannels + 1] = {};
+    float* heldOutputs[kMaxAudioChannels + kStemChannels * maxStemOutputs + kVoiceChannels] = {};
+    for (int ch = 0; ch < numCoreInputs; ++ch)
+      heldInputs[ch] = inBuffers[ch] + coreHoldSamples;
+    for (int ch = 0; ch < numOutputs; ++ch)
+    {
+      juce::FloatVectorOperations::clear(outBuffers[ch], coreHoldSamples);
+      heldOutputs[ch] = outBuffers[ch] + coreHoldSamples;
+    }
+    if (coreSamples > 0)
+      client.AudioProc(heldInputs, numCoreInputs, heldOutputs, numOutputs,
+                       coreSamples, safeSampleRate, false, isPlaying, isSeek, sessionPos);
+  }
+  else
+  {
+    client.AudioProc(inBuffers, numCoreInputs, outBuffers, numOutputs,
+                     blockSize, safeSampleRate, false, isPlaying, isSeek, sessionPos);
+  }
+  const auto audioProcTicks = juce::Time::getHighResolutionTicks() - audioProcStartTicks;
+  storeMaxTicks(worstAudioProcTicks, audioProcTicks);
+
+  const double budgetSeconds = kAudioProcBudgetFraction * static_cast<double>(blockSize) / static_cast<double>(safeSampleRate);
+  if (juce::Time::highResolutionTicksToSeconds(audioProcTicks) > budgetSeconds)
+    audioProcOverruns.fetch_add(1, std::memory_order_relaxed);
+
+  // Once enough input is queued for encoding, ask the network thread to
+  // skip its next poll wait. A flag rather than an event: signalling the
+  // event would lock a mutex here.
+  const int consumedSamples = coreSamples + coreAdvanceSamples;
+  submittedEncodeSamples.fetch_add(consumedSamples, std::memory_order_release);
+  pendingEncodeSamples += consumedSamples;
+  if (pendingEncodeSamples >= kEncodeWakeSamples)
+  {
+    pendingEncodeSamples = 0;
+    encodeWakePending.store(true, std::memory_order_release);
+  }
+
+  // ── OUTPUT RING: remap receiver audio from server-position → DAW-beat order ──
+  // Server position 0 maps to DAW beat 0. The kernels below read the ring
+  // straight into the host buffer; -1 means output comes from outputScratch.
+  int ringReadPos = -1;
+  int ringReadLen = 0;
+  int stemReadPos = 0;
+  const float* ringChannels[kMaxAudioChannels] = {};
+  if (usePhaseRing && !directAligned)
+  {
+    int serverPosAfter = 0, intervalLen = 0;
+    client.GetPosition(&serverPosAfter, &intervalLen);
+    if (serverPosAfter < 0) serverPosAfter = 0;
+
+    if (intervalLen > ringCapacity && intervalLen != lastRingCapacityWarningLen)
+    {
+      lastRingCapacityWarningLen = intervalLen;
+      postEvent(ServiceEvent::Type::RingCapacityExceeded, intervalLen);
+    }
+
+    if (intervalLen > 0 && intervalLen >= blockSize && intervalLen <= ringCapacity)
+    {
+      // Write AudioProc output at server position. A new interval length
+      // restarts the ring empty.
+      if (PhaseRings::writeOutput(phaseRingBuffer, outputScratch, numChannels, blockSize, serverPosAfter, intervalLen)
+          && resyncElapsedSamples < 0)
+        resyncElapsedSamples = 0;
+
+      // Stem rings follow the main ring's geometry; one published mid-
+      // interval fills from here on like a ring after a resync.
+      for (int slot = 0; slot < numStems; ++slot)
       {
-        const double rawDelta = phaseBeat - lastHostPhaseBeat;
-        const double expected = juce::jmax(1.0e-6, beatsPerBlock);
-        const double candidates[3] = { rawDelta, rawDelta + bpiD, rawDelta - bpiD };
+        if (!stemRingReady[slot].load(std::memory_order_acquire))
+          continue;
+        juce::AudioBuffer<float> stemOutput(outputScratch.getArrayOfWritePointers() + kMaxAudioChannels + kStemChannels * slot,
+                                            kStemChannels, blockSize);
+        PhaseRings::writeOutput(stemRings[slot], stemOutput, kStemChannels, blockSize, serverPosAfter, intervalLen);
+      }
+
+      // Server position 0 is DAW beat 0, so the read position follows from
+      // the DAW phase alone and is valid from the first block after a
+      // resync; spans NJClient has not written since then play as silence.
+      const int manualOffsetSamples = static_cast<int>(
+        static_cast<double>(phaseOffsetMsValue) * 0.001 * static_cast<double>(safeSampleRate));
+      const int readPos = PhaseRings::beatToPosition(rawDawPhase, roomBpi, intervalLen) + manualOffsetSamples;
+      const auto ringRead = PhaseRings::readOutput(phaseRingBuffer, phaseRingReadScratch, ringChannels,
+                                                   numChannels, blockSize, readPos);
+      ringReadPos = ringRead.pos;
+      ringReadLen = ringRead.len;
+      stemReadPos = readPos;
+    }
+  }
+
+  // Time to sync runs from the resync until a block plays on the DAW grid.
+  if (resyncElapsedSamples >= 0)
+  {
+    resyncElapsedSamples += blockSize;
+    if (ringReadPos >= 0 || directLocked)
+    {
+      const auto ms = static_cast<float>(1000.0 * static_cast<double>(resyncElapsedSamples) / static_cast<double>(safeSampleRate));
+      lastTimeToSyncMs.store(ms, std::memory_order_relaxed);
+      resyncsCompleted.fetch_add(1, std::memory_order_relaxed);
+      postEvent(ServiceEvent::Type::SyncAligned, juce::roundToInt(ms));
+      resyncElapsedSamples = -1;
+    }
+  }
 
-        double bestDelta = expected;
-        double bestScore = expected;
-        for (double c : candidates)
+  // ── Write output through the kernel specialised for this configuration ──
+  const bool readRing = ringReadPos >= 0;
+  const float* ringBuffers[2] = { ringChannels[0], ringChannels[kMaxAudioChannels - 1] };
+  const float* remoteBuffers[2] = { outBuffers[0], outBuffers[1] };
+
+  AudioKernels::OutputArgs args;
+  args.host = hostBuffers;
+  args.remote = remoteBuffers;
+  args.ring = ringBuffers;
+  args.ringPos = ringReadPos;
+  args.ringLen = ringReadLen;
+  args.numSamples = blockSize;
+  args.localGain = localGainValue;
+  args.remoteGain = remoteGainValue;
+  selectOutputKernel(numChannels, readRing, monitorMode)(args);
+
+  // Stems carry remote audio only, through the same ring read as the main
+  // bus so every stem stays on the DAW beat grid.
+  if (monitorMode == MonitorMode::ListenLocal)
+  {
+    clearStemOutputs(buffer, numStems, blockSize);
+  }
+  else
+  {
+    for (int slot = 0; slot < numStems; ++slot)
+    {
+      const int scratchChannel = kMaxAudioChannels + kStemChannels * slot;
+      float* stemHost[kStemChannels] = { buffer.getWritePointer(stemFirstChannels[slot]),
+                                         buffer.getWritePointer(stemFirstChannels[slot] + 1) };
+      if (readRing)
+      {
+        // A slot nobody has been routed to has no ring yet and is silent.
+        if (!stemRingReady[slot].load(std::memory_order_acquire))
         {
-          if (c < -0.02)
-            continue;
-          const double score = std::abs(juce::jmax(0.0, c) - expected);
-          if (score < bestScore)
-          {
-            bestScore = score;
-            bestDelta = juce::jmax(0.0, c);
-          }
+          for (auto* channel : stemHost)
+            juce::FloatVectorOperations::clear(channel, blockSize);
+          continue;
         }
-
-        bestDelta = juce::jlimit(0.0, juce::jmax(expected * 8.0, 0.75), bestDelta);
-        hostPhaseAccumulatorBeats += bestDelta;
-        lastHostPhaseBeat = phaseBeat;
+        const float* stemRing[kStemChannels] = {};
+        const auto stemRead = PhaseRings::readOutput(stemRings[slot], stemRingReadScratch, stemRing,
+                                                     kStemChannels, blockSize, stemReadPos);
+        AudioKernels::mixRing<kStemChannels, false>(stemHost, stemRing, stemRead.pos, stemRead.len, blockSize, remoteGainValue);
+      }
+      else
+      {
+        const float* stemRemote[kStemChannels] = { outBuffers[scratchChannel], outBuffers[scratchChannel + 1] };
+        AudioKernels::mixRemote<kStemChannels, false>(stemHost, stemRemote, blockSize, remoteGainValue);
       }
-
-      sessionPos = hostPhaseAccumulatorBeats * 60.0 / sessionBpm;
-      rawDawPhase = phaseBeat;
     }
-    else if (hasHostClock)
+
+    // Voice chat is streamed in small chunks and played as it arrives,
+    // so it is mixed after the ring read rather than re-aligned.
+    if (voiceOutput)
     {
-      syncMode = syncFallbackStopped;
+      const float* voice[kVoiceChannels] = { outBuffers[numRingOutputs], outBuffers[numRingOutputs + 1] };
+      AudioKernels::mixRemote<kVoiceChannels, true>(hostBuffers, voice, blockSize, remoteGainValue);
     }
+  }
+
+  float outputPeak = 0.0f;
+  if (monitorMode == MonitorMode::ListenLocal)
+  {
+    outputPeak = sendPeak * localGainValue;
+  }
+  else
+  {
+    if ((readRing || directAligned) && metronomeEnabled)
+      renderMetronome(hostBuffers, numChannels, blockSize, sessionBpm, roomBpi, rawDawPhase,
+                      safeSampleRate, remoteGainValue);
+    outputPeak = measurePeak(buffer, numChannels, blockSize);
+  }
+
+  // ── Update meters ──
+  localMeterSlot.publish(clampMeter(outputPeak));
+  publishRemoteMeter();
+  trackBlockTime(blockStartTicks);
+}
+
+AudioKernels::OutputKernel NinjamClientService::selectOutputKernel(int numChannels, bool readRing, MonitorMode mode)
+{
+  // Re-resolve only when the configuration changes.
+  const int key = ((numChannels - 1) * 2 + (readRing ? 1 : 0)) * 3 + static_cast<int>(mode);
+  if (key != outputKernelKey)
+  {
+    outputKernelKey = key;
+    outputKernel = AudioKernels::selectOutputKernel(numChannels, readRing, static_cast<int>(mode));
+  }
+  return outputKernel;
+}
+
+void NinjamClientService::clearStemOutputs(juce::AudioBuffer<float>& buffer, int numStems, int numSamples)
+{
+  // Stem channels can alias send-bus inputs in the host buffer.
+  for (int slot = 0; slot < numStems; ++slot)
+  {
+    for (int ch = 0; ch < kStemChannels; ++ch)
+      buffer.clear(stemFirstChannels[slot] + ch, 0, numSamples);
+  }
+}
+
+void NinjamClientService::publishRemoteMeter()
+{
+  const auto remote = client.GetOutputPeak();
+  remoteMeterSmoothed = clampMeter(remoteMeterSmoothed * kRemoteMeterDecay + remote * (1.0f - kRemoteMeterDecay));
+  remoteMeterSlot.publish(remoteMeterSmoothed);
+}
+
+void NinjamClientService::trackBlockTime(juce::int64 blockStartTicks)
+{
+  storeMaxTicks(worstBlockTicks, juce::Time::getHighResolutionTicks() - blockStartTicks);
+}
 
-    if (syncMode != syncHostLocked)
+void NinjamClientService::storeMaxTicks(std::atomic<juce::int64>& target, juce::int64 ticks)
+{
+  // Peak-held until the next status refresh takes it.
+  auto worst = target.load(std::memory_order_relaxed);
+  while (ticks > worst && !target.compare_exchange_weak(worst, ticks, std::memory_order_relaxed))
+  {
+  }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Settings
+// ─────────────────────────────────────────────────────────────────────────────
+
+void NinjamClientService::prepare(int sampleRateHz, int maximumBlockSize, int numMainChannels, int numInputChannels)
+{
+  // Called from prepareToPlay, so the audio thread is not running and
+  // audio-thread-owned buffers may be (re)allocated here.
+  const int safeSampleRate = juce::jmax(sampleRateHz, 1);
+  const int safeBlockSize = juce::jmax(maximumBlockSize, 1);
+  sampleRate.store(safeSampleRate);
+  maxSubBlockSamples = juce::jmin(kMaxSubBlockSamples, safeBlockSize);
+
+  hostMainChannels = juce::jlimit(1, kMaxAudioChannels, numMainChannels);
+  const int inputChannels = juce::jlimit(kMaxAudioChannels, kMaxInputChannels, numInputChannels);
+  const bool inputsChanged = inputChannels != hostInputChannels;
+  hostInputChannels = inputChannels;
+
+  inputScratch.setSize(hostInputChannels, safeBlockSize, false, true, false);
+  const int outputChannels = kMaxAudioChannels + kStemChannels * numStemOutputs;
+  const bool storageChanged = ringCompactStorage != phaseRingBuffer.isCompact();
+  outputScratch.setSize(outputChannels + kVoiceChannels, safeBlockSize, false, true, false);
+  voiceOutputAvailable.store(hostMainChannels == kMaxAudioChannels);
+  stemRoutingDirty.store(true);
+
+  const double longestIntervalSeconds = static_cast<double>(ringLimitMaxBpi) * 60.0
+                                      / static_cast<double>(ringLimitMinBpm);
+  const int capacity = static_cast<int>(std::ceil(longestIntervalSeconds * static_cast<double>(safeSampleRate)));
+
+  {
+    // The network thread allocates stem rings under the same lock.
+    const juce::ScopedLock clientScope(clientLock);
+    if (capacity != ringCapacity || inputsChanged || storageChanged)
     {
-      isPlaying = true;
-      isSeek = false;
-      if (forceSeekPending)
+      phaseRingBuffer.allocate(kMaxAudioChannels, capacity, ringCompactStorage);
+      inputRingBuffer.allocate(hostInputChannels, capacity, ringCompactStorage);
+      ringCapacity = capacity;
+      ringsCompactPublished.store(ringCompactStorage);
+
+      // Slots already in use move to the new geometry now; the rest wait
+      // until a user is routed to them.
+      for (int slot = 0; slot < maxStemOutputs; ++slot)
       {
-        isSeek = true;
-        forceSeekPending = false;
+        if (stemRingReady[slot].load())
+          stemRings[slot].allocate(kStemChannels, capacity, ringCompactStorage);
       }
-      if (isSeek)
-        hostPhaseAccumulatorValid = false;
-      sessionPos = client.GetSessionPosition() / 1000.0;
     }
 
-    hostLockedActive = (syncMode == syncHostLocked);
+    // Stem buses the host disabled give their rings back.
+    for (int slot = numStemOutputs; slot < maxStemOutputs; ++slot)
+    {
+      stemRingReady[slot].store(false);
+      stemRings[slot].allocate(0, 0, false);
+    }
+    publishRingStorageBytes();
   }
 
-  // ── Configure NJClient metronome ──
-  // When host-locked, we mute NJClient's metronome and render our own
-  // (phase-aligned to DAW beats). Otherwise let NJClient handle it.
-  const bool usePhaseRing = (syncMode == syncHostLocked);
-  if (usePhaseRing)
+  if (ringCompactStorage)
   {
-    client.config_metronome_mute = true;
+    phaseRingReadScratch.setSize(kMaxAudioChannels, safeBlockSize, false, true, false);
+    stemRingReadScratch.setSize(kStemChannels, safeBlockSize, false, true, false);
   }
   else
   {
-    client.config_metronome_mute = !metronomeEnabled;
+    phaseRingReadScratch.setSize(0, 0);
+    stemRingReadScratch.setSize(0, 0);
   }
 
-  // ── Log sync mode changes ──
-  if (syncMode != lastSyncMode)
+  lastRingCapacityWarningLen = 0;
+  rebuildMetronomeClicks(safeSampleRate);
+}
+
+void NinjamClientService::setLocalSends(const std::vector<LocalSend>& sends)
+{
+  // Local channel 0 is the main bus ("Me"); sends take the indices after it.
+  const int numSends = juce::jmin(kMaxLocalSends, static_cast<int>(sends.size()));
   {
-    const juce::ScopedLock scopedLock(lock);
-    switch (syncMode)
+    const juce::ScopedLock clientScope(clientLock);
+    for (int i = 0; i < numSends; ++i)
     {
-      case syncHostLocked:       state.syncStateText = "Host Locked"; break;
-      case syncFallbackStopped:  state.syncStateText = "Fallback (Host Stopped)"; break;
-      case syncFallbackNoClock:  state.syncStateText = "Fallback (No Host Clock)"; break;
+      const auto& send = sends[static_cast<size_t>(i)];
+      const int ch = i + 1;
+      const int bitrate = juce::jlimit(kMinSendBitrateKbps, kMaxSendBitrateKbps, send.bitrateKbps);
+      const bool stereo = send.numChannels > 1;
+      const int firstChannel = juce::jlimit(0, kMaxInputChannels - (stereo ? 2 : 1), send.firstChannel);
+      configuredSendBitrates[ch] = bitrate;
+      client.SetLocalChannelInfo(ch, send.name.toRawUTF8(),
+                                 true, stereo ? (firstChannel | kStereoSourceFlag) : firstChannel,
+                                 true, effectiveSendBitrate(bitrate),
+                                 true, !silenceGated, true, 0, true, 0);
+      // As for channel 0, monitoring is left to the plugin.
+      client.SetLocalChannelMonitoring(ch, true, 1.0f, true, 0.0f, true, true, true, false);
     }
-    lastSyncMode = syncMode;
+
+    for (int ch = numSends + 1; ch <= activeLocalSends; ++ch)
+    {
+      client.DeleteLocalChannel(ch);
+      configuredSendBitrates.erase(ch);
+    }
+
+    client.NotifyServerOfChannelChange();
   }
+  networkWakeEvent.signal();
 
-  // ── Prepare scratch buffers ──
-  if (inputScratch.getNumChannels() != numChannels || inputScratch.getNumSamples() != blockSize)
-    inputScratch.setSize(numChannels, blockSize, false, false, true);
-  for (int ch = 0; ch < numChannels; ++ch)
-    inputScratch.copyFrom(ch, 0, buffer, ch, 0, blockSize);
+  if (numSends != activeLocalSends)
+    addLogLine("Local sends: " + juce::String(numSends) + " additional channel(s)");
+  activeLocalSends = numSends;
+}
 
-  const bool addLocalMonitor = (monitorMode == MonitorMode::AddLocal);
-  const bool monitorTxAudio = (monitorMode == MonitorMode::ListenLocal);
+void NinjamClientService::setTalkbackSource(int firstChannel)
+{
+  // Called from prepareToPlay; -1 disables the talkback channel.
+  const bool enable = firstChannel >= 0;
+  talkbackSourceChannel = enable ? firstChannel : -1;
+  talkbackOldestUnsentTicks.store(0);
 
-  if (monitorTxAudio || addLocalMonitor)
   {
-    if (txMonitorScratch.getNumChannels() != numChannels || txMonitorScratch.getNumSamples() != blockSize)
-      txMonitorScratch.setSize(numChannels, blockSize, false, false, true);
-    for (int ch = 0; ch < numChannels; ++ch)
-      txMonitorScratch.copyFrom(ch, 0, inputScratch, ch, 0, blockSize);
+    const juce::ScopedLock clientScope(clientLock);
+    if (enable)
+    {
+      client.SetLocalChannelInfo(kTalkbackLocalChannel, "Talkback",
+                                 true, kTalkbackInputIndex, true, kTalkbackBitrateKbps, true, true,
+                                 true, 0, true, kVoiceChatFlag);
+      client.SetLocalChannelMonitoring(kTalkbackLocalChannel, true, 1.0f, true, 0.0f, true, true, true, false);
+    }
+    else if (talkbackActive)
+    {
+      client.DeleteLocalChannel(kTalkbackLocalChannel);
+    }
+    client.NotifyServerOfChannelChange();
   }
+  networkWakeEvent.signal();
 
-  if (monitorTxAudio || addLocalMonitor)
-    txMonitorScratch.applyGain(localGainValue);
+  if (enable != talkbackActive)
+    addLogLine(enable ? "Talkback channel enabled (voice chat mode)" : "Talkback channel disabled");
+  talkbackActive = enable;
+}
+
+void NinjamClientService::setStemOutputs(const std::vector<int>& firstChannels)
+{
+  // Called before prepare(), which sizes the output scratch and ring for
+  // the stems.
+  numStemOutputs = juce::jmin(maxStemOutputs, static_cast<int>(firstChannels.size()));
+  for (int slot = 0; slot < numStemOutputs; ++slot)
+    stemFirstChannels[slot] = firstChannels[static_cast<size_t>(slot)];
 
-  // Measure send level from the input feeding NJClient.
+  if (stemSlotCount.exchange(numStemOutputs) != numStemOutputs)
   {
-    float sendPeak = 0.0f;
-    for (int ch = 0; ch < numChannels; ++ch)
-      sendPeak = juce::jmax(sendPeak, inputScratch.getMagnitude(ch, 0, blockSize));
-    const juce::ScopedLock scopedLock(lock);
-    state.sendMeter = clampMeter(sendPeak);
+    stemRoutingDirty.store(true);
+    networkWakeEvent.signal();
+    addLogLine("Stem outputs: " + juce::String(numStemOutputs));
   }
+}
 
-  if (outputScratch.getNumChannels() != numChannels || outputScratch.getNumSamples() != blockSize)
-    outputScratch.setSize(numChannels, blockSize, false, false, true);
-  outputScratch.clear();
+void NinjamClientService::setIntervalLimits(int minBpm, int maxBpi)
+{
+  // Takes effect on the next prepare().
+  ringLimitMinBpm = juce::jlimit(kRingLimitMinBpm, 400, minBpm);
+  ringLimitMaxBpi = juce::jlimit(1, kRingLimitMaxBpi, maxBpi);
+}
+
+void NinjamClientService::setCompactRingStorage(bool enabled)
+{
+  // Takes effect on the next prepare().
+  ringCompactStorage = enabled;
+}
+
+void NinjamClientService::setMonitorMode(MonitorMode mode)
+{
+  if (monitorModeParam.exchange(static_cast<int>(mode)) == static_cast<int>(mode))
+    return;
 
-  float* inBuffers[2] = { inputScratch.getWritePointer(0), nullptr };
-  float* outBuffers[2] = { outputScratch.getWritePointer(0), nullptr };
-  if (numChannels > 1)
+  const juce::ScopedLock scopedLock(lock);
+  switch (mode)
   {
-    inBuffers[1] = inputScratch.getWritePointer(1);
-    outBuffers[1] = outputScratch.getWritePointer(1);
+    case MonitorMode::IncomingOnly: appendLogLineUnlocked("Monitor mode: incoming only"); break;
+    case MonitorMode::AddLocal:     appendLogLineUnlocked("Monitor mode: add local"); break;
+    case MonitorMode::ListenLocal:  appendLogLineUnlocked("Monitor mode: listen local"); break;
   }
-  else
+}
+
+NinjamClientService::MonitorMode NinjamClientService::getMonitorMode() const
+{
+  return static_cast<MonitorMode>(monitorModeParam.load());
+}
+
+void NinjamClientService::setMetronomeEnabled(bool enabled)
+{
+  metronomeEnabledParam.store(enabled);
+}
+
+bool NinjamClientService::getMetronomeEnabled() const
+{
+  return metronomeEnabledParam.load();
+}
+
+void NinjamClientService::setAlignmentMode(AlignmentMode mode)
+{
+  alignmentModeParam.store(static_cast<int>(mode));
+}
+
+NinjamClientService::AlignmentMode NinjamClientService::getAlignmentMode() const
+{
+  return static_cast<AlignmentMode>(alignmentModeParam.load());
+}
+
+void NinjamClientService::setLocalGain(float value)
+{
+  localGainParam.store(juce::jlimit(0.0f, kGainMaxLinear, value));
+}
+
+void NinjamClientService::setRemoteGain(float value)
+{
+  remoteGainParam.store(juce::jlimit(0.0f, kGainMaxLinear, value));
+}
+
+float NinjamClientService::getLocalGain() const
+{
+  return localGainParam.load();
+}
+
+float NinjamClientService::getRemoteGain() const
+{
+  return remoteGainParam.load();
+}
+
+void NinjamClientService::setPhaseOffsetMs(float ms)
+{
+  phaseOffsetMsParam.store(juce::jlimit(-500.0f, 500.0f, ms));
+}
+
+void NinjamClientService::setUserChannelMute(int userIdx, int channelIdx, bool mute)
+{
+  const juce::ScopedLock clientScope(clientLock);
+  client.SetUserChannelState(userIdx, channelIdx,
+                             false, false, false, 0.0f, false, 0.0f,
+                             true, mute, false, false);
+  subscriptionDirty.store(true);
+}
+
+void NinjamClientService::setUserChannelSolo(int userIdx, int channelIdx, bool solo)
+{
+  const juce::ScopedLock clientScope(clientLock);
+  client.SetUserChannelState(userIdx, channelIdx,
+                             false, false, false, 0.0f, false, 0.0f,
+                             false, false, true, solo);
+  subscriptionDirty.store(true);
+}
+
+void NinjamClientService::setUserChannelVolume(int userIdx, int channelIdx, float volume)
+{
+  const juce::ScopedLock clientScope(clientLock);
+  client.SetUserChannelState(userIdx, channelIdx,
+                             false, false, true, juce::jlimit(0.0f, kGainMaxLinear, volume),
+                             false, 0.0f, false, false, false, false);
+}
+
+void NinjamClientService::setSubscriptionPolicy(SubscriptionPolicy policy, int maxSubscriptions,
+                                                const juce::StringArray& priorityUsers)
+{
   {
-    inBuffers[1] = inBuffers[0];
-    outBuffers[1] = outBuffers[0];
+    const juce::ScopedLock scopedLock(lock);
+    subscriptionPriority = priorityUsers;
   }
+  subscriptionPolicyParam.store(static_cast<int>(policy));
+  maxSubscriptionsParam.store(juce::jmax(0, maxSubscriptions));
+  subscriptionDirty.store(true);
+}
 
-  // ── Process audio through NJClient ──
-  bool renderedByClient = false;
-  if (client.GetStatus() == NJClient::NJC_STATUS_OK)
+float NinjamClientService::getPhaseOffsetMs() const
+{
+  return phaseOffsetMsParam.load();
+}
+
+NinjamClientService::Snapshot NinjamClientService::getSnapshot() const
+{
+  Snapshot snapshot;
   {
-    renderedByClient = true;
-    const int safeSampleRate = juce::jmax(sampleRate, 1);
+    const juce::ScopedLock scopedLock(lock);
+    snapshot = state;
+  }
 
-    // ── INPUT RING: remap sender audio from DAW-beat → server-position order ──
-    // Ensures DAW beat 0 audio always lands at server interval position 0,
-    // so the receiver's output ring can map it back to their own beat 0.
-    if (usePhaseRing && phaseRingOffsetValid)
-    {
-      int serverPosBefore = 0, intervalLenBefore = 0;
-      client.GetPosition(&serverPosBefore, &intervalLenBefore);
-      if (serverPosBefore < 0) serverPosBefore = 0;
+  snapshot.localGain = localGainParam.load();
+  snapshot.remoteGain = remoteGainParam.load();
+  snapshot.phaseOffsetMs = phaseOffsetMsParam.load();
+  snapshot.monitorMode = static_cast<MonitorMode>(monitorModeParam.load());
+  snapshot.metronomeEnabled = metronomeEnabledParam.load();
+  snapshot.alignmentMode = static_cast<AlignmentMode>(alignmentModeParam.load());
+  snapshot.directAlignActive = directAlignActive.load();
+  snapshot.alignmentErrorSamples = snapshot.directAlignActive ? alignmentErrorSamples.load() : 0;
+  snapshot.alignmentCorrections = alignmentCorrections.load();
+  snapshot.lastTimeToSyncMs = lastTimeToSyncMs.load();
+  snapshot.resyncsCompleted = resyncsCompleted.load();
+  snapshot.ringStorageBytes = ringStorageBytes.load();
+  snapshot.ringsCompact = ringsCompactPublished.load();
+  snapshot.syncStateText = syncModeToText(publishedSyncMode.load());
+  if (snapshot.directAlignActive)
+    snapshot.syncStateText += " (Direct)";
+  return snapshot;
+}
 
-      if (intervalLenBefore > 0 && intervalLenBefore >= blockSize)
-      {
-        const double bpi = static_cast<double>(roomBpi);
-        const double ilen = static_cast<double>(intervalLenBefore);
-        double dawBeat = std::fmod(rawDawPhase, bpi);
-        if (dawBeat < 0.0) dawBeat += bpi;
+void NinjamClientService::addLogLine(const juce::String& message)
+{
+  const juce::ScopedLock scopedLock(lock);
+  appendLogLineUnlocked(message);
+}
 
-        if (intervalLenBefore != inputRingIntervalLen)
-        {
-          inputRingBuffer.setSize(numChannels, intervalLenBefore, false, true, false);
-          inputRingIntervalLen = intervalLenBefore;
-        }
+// ─────────────────────────────────────────────────────────────────────────────
+// Timer / network thread
+// ─────────────────────────────────────────────────────────────────────────────
 
-        // Write at DAW beat position
-        int writePos = static_cast<int>(dawBeat / bpi * ilen);
-        writePos = ((writePos % intervalLenBefore) + intervalLenBefore) % intervalLenBefore;
-        ringCopy(inputRingBuffer, writePos, inputScratch, 0, numChannels, blockSize, intervalLenBefore);
+void NinjamClientService::timerCallback()
+{
+  drainEvents();
+}
 
-        // Read at server position → overwrite inputScratch for NJClient
-        int readPos = ((serverPosBefore % intervalLenBefore) + intervalLenBefore) % intervalLenBefore;
-        ringCopy(inputScratch, 0, inputRingBuffer, readPos, numChannels, blockSize, intervalLenBefore);
-      }
-    }
+void NinjamClientService::run()
+{
+  const auto ticksPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+  const auto statusRefreshTicks = static_cast<juce::int64>(kStatusRefreshSeconds * ticksPerSecond);
+  juce::int64 lastStatusRefreshTicks = 0;
+  juce::int64 scheduledWakeTicks = 0;
 
-    client.AudioProc(inBuffers, numChannels, outBuffers, numChannels,
-                     blockSize, safeSampleRate, false, isPlaying, isSeek, sessionPos);
+  networkWindowStartTicks = juce::Time::getHighResolutionTicks();
 
-    // ── OUTPUT RING: remap receiver audio from server-position → DAW-beat order ──
-    // Server position 0 maps to DAW beat 0.
-    if (usePhaseRing)
-    {
-      int serverPosAfter = 0, intervalLen = 0;
-      client.GetPosition(&serverPosAfter, &intervalLen);
-      if (serverPosAfter < 0) serverPosAfter = 0;
+  while (!threadShouldExit())
+  {
+    const auto wakeTicks = juce::Time::getHighResolutionTicks();
 
-      if (intervalLen > 0 && intervalLen >= blockSize)
+    {
+      const juce::ScopedLock clientScope(clientLock);
+      const auto submittedBeforeRun = submittedEncodeSamples.load(std::memory_order_acquire);
+      const auto talkbackCaptureTicks = talkbackOldestUnsentTicks.exchange(0);
+      if (runClientOnce())
       {
-        // Resize ring on interval length change; invalidate calibration
-        if (intervalLen != phaseRingIntervalLen)
-        {
-          phaseRingBuffer.setSize(numChannels, intervalLen, false, true, false);
-          phaseRingIntervalLen = intervalLen;
-          phaseRingOffsetValid = false;
-
-          // Seed with partial block at boundary
-          if (serverPosAfter > 0 && serverPosAfter <= blockSize)
-          {
-            for (int ch = 0; ch < numChannels; ++ch)
-              phaseRingBuffer.copyFrom(ch, 0, outBuffers[ch] + (blockSize - serverPosAfter), serverPosAfter);
-          }
-        }
-        else
+        updateEncodeMetrics(submittedBeforeRun);
+        if (talkbackCaptureTicks > 0)
         {
-          // Write AudioProc output at server position
-          int writePos = serverPosAfter - blockSize;
-          if (writePos < 0) writePos += intervalLen;
-          ringCopy(phaseRingBuffer, writePos, outputScratch, 0, numChannels, blockSize, intervalLen);
+          const auto latencyMs = static_cast<float>(juce::Time::highResolutionTicksToSeconds(
+            juce::Time::getHighResolutionTicks() - talkbackCaptureTicks) * 1000.0);
+          talkbackSendLatencyPeakMs = juce::jmax(talkbackSendLatencyPeakMs, latencyMs);
         }
+      }
 
-        const double bpi = static_cast<double>(roomBpi);
-        const double ilen = static_cast<double>(intervalLen);
+      // Subscribing never cuts an interval short (the server starts at
+      // the next one), so additions go out right away; unsubscribes wait
+      // for the boundary.
+      if (subscriptionDirty.exchange(false))
+      {
+        applySubscriptionPolicy(false);
+        unsubscribePending = true;
+      }
 
-        // Calibrate once at first interval boundary after connect/BPM/BPI change.
-        // Records DAW phase at the moment the server interval wraps to 0.
-        if (!phaseRingOffsetValid && serverPosAfter > 0 && serverPosAfter <= blockSize)
-        {
-          phaseRingBeatOffset = rawDawPhase;
-          phaseRingOffsetValid = true;
-        }
+      const bool sessionConnected = client.GetStatus() == NJClient::NJC_STATUS_OK;
+      if (sessionConnected && !networkSessionConnected)
+        resetSessionTracking(wakeTicks);
+      networkSessionConnected = sessionConnected;
 
-        const int manualOffsetSamples = static_cast<int>(
-          static_cast<double>(phaseOffsetMsValue) * 0.001 * static_cast<double>(safeSampleRate));
+      bool wrapped = false;
+      if (pollIntervalBoundary(wakeTicks, wrapped))
+        handleIntervalBoundary(wrapped);
+      trackPlaybackStarts(wakeTicks, wrapped);
+      updateSilenceGate(wakeTicks, wrapped);
 
-        int readPos;
-        if (phaseRingOffsetValid)
-        {
-          // Read at DAW beat position (beat 0 → server position 0)
-          double dawBeat = std::fmod(rawDawPhase, bpi);
-          if (dawBeat < 0.0) dawBeat += bpi;
-          readPos = static_cast<int>(dawBeat / bpi * ilen) + manualOffsetSamples;
-        }
-        else
-        {
-          // Pre-calibration: pass through (track server position)
-          readPos = serverPosAfter - blockSize + manualOffsetSamples;
-        }
-        readPos = ((readPos % intervalLen) + intervalLen) % intervalLen;
+      // Status and roster are published to the GUI through `state`; the
+      // editor picks them up on its own timer.
+      if (wakeTicks - lastStatusRefreshTicks >= statusRefreshTicks)
+      {
+        lastStatusRefreshTicks = wakeTicks;
+        refreshStatusFromCore();
+      }
+    }
 
-        outputScratch.clear();
-        ringCopy(outputScratch, 0, phaseRingBuffer, readPos, numChannels, blockSize, intervalLen);
+    const auto busyTicks = juce::Time::getHighResolutionTicks() - wakeTicks;
+    updateNetworkMetrics(wakeTicks, busyTicks, scheduledWakeTicks);
 
-        if (metronomeEnabled)
-          renderMetronome(outBuffers, numChannels, blockSize, sessionBpm, roomBpi, rawDawPhase, safeSampleRate);
-      }
+    // NJClient does not expose its sockets, so socket readiness is covered
+    // by a short poll while connected. Encode work the audio thread queued
+    // during this pass is picked up straight away; work queued during the
+    // wait waits for the poll, at most kNetworkPollMsConnected.
+    if (encodeWakePending.exchange(false, std::memory_order_acquire))
+    {
+      scheduledWakeTicks = 0;
+      continue;
     }
+
+    const bool connected = client.GetStatus() == NJClient::NJC_STATUS_OK;
+    const int timeoutMs = connected ? kNetworkPollMsConnected : kNetworkPollMsIdle;
+    scheduledWakeTicks = juce::Time::getHighResolutionTicks()
+                       + static_cast<juce::int64>(timeoutMs * 0.001 * ticksPerSecond);
+    if (networkWakeEvent.wait(static_cast<double>(timeoutMs)))
+      scheduledWakeTicks = 0;
   }
+}
 
-  // ── Write output ──
-  if (monitorTxAudio)
+bool NinjamClientService::runClientOnce()
+{
+  bool idle = false;
+  for (int i = 0; i < kMaxRunIterations && !idle; ++i)
+    idle = client.Run() != 0;
+
+  const bool stemsDirty = stemRoutingDirty.exchange(false);
+  if (client.HasUserInfoChanged() != 0)
   {
-    for (int ch = 0; ch < numChannels; ++ch)
-      buffer.copyFrom(ch, 0, txMonitorScratch, ch, 0, blockSize);
+    subscriptionDirty.store(true);
+    warnIfDuplicateUsername();
+    routeRemoteChannels();
   }
-  else if (renderedByClient)
+  else if (stemsDirty)
   {
-    for (int ch = 0; ch < numChannels; ++ch)
-      buffer.copyFrom(ch, 0, outputScratch, ch, 0, blockSize);
-    if (remoteGainValue != 1.0f)
-      buffer.applyGain(remoteGainValue);
+    routeRemoteChannels();
+  }
 
-    if (addLocalMonitor)
-    {
-      for (int ch = 0; ch < numChannels; ++ch)
-        buffer.addFrom(ch, 0, txMonitorScratch, ch, 0, blockSize);
-    }
+  return idle;
+}
+
+void NinjamClientService::updateNetworkMetrics(juce::int64 wakeTicks, juce::int64 busyTicks, juce::int64 scheduledWakeTicks)
+{
+  // Jitter is only meaningful for timeout wakeups; signalled wakeups are early by design.
+  if (scheduledWakeTicks > 0)
+    networkWindowMaxJitterTicks = juce::jmax(networkWindowMaxJitterTicks, wakeTicks - scheduledWakeTicks);
+  networkWindowBusyTicks += busyTicks;
+
+  const auto now = wakeTicks + busyTicks;
+  const auto windowSeconds = juce::Time::highResolutionTicksToSeconds(now - networkWindowStartTicks);
+  if (windowSeconds < kNetworkMetricsWindowSeconds)
+    return;
+
+  networkDutyCycle = static_cast<float>(juce::Time::highResolutionTicksToSeconds(networkWindowBusyTicks) / windowSeconds);
+  networkWakeJitterMs = static_cast<float>(juce::Time::highResolutionTicksToSeconds(networkWindowMaxJitterTicks) * 1000.0);
+  networkWindowStartTicks = now;
+  networkWindowBusyTicks = 0;
+  networkWindowMaxJitterTicks = 0;
+}
+
+void NinjamClientService::updateEncodeMetrics(juce::int64 submittedBeforeRun)
+{
+  // A Run() pass that reached idle has drained every block AudioProc queued
+  // before it was entered, so the backlog seen at entry is what the
+  // encoders still had to catch up on.
+  const auto backlog = static_cast<int>(juce::jlimit<juce::int64>(0, std::numeric_limits<int>::max(),
+                                                                 submittedBeforeRun - encodedSamples));
+  encodeBacklogPeak = juce::jmax(encodeBacklogPeak, backlog);
+  encodeBacklogIntervalPeak = juce::jmax(encodeBacklogIntervalPeak, backlog);
+  encodedSamples = submittedBeforeRun;
+
+  // The first pass after an interval wrap finishes encoding the previous
+  // interval. Peers start playing it one interval later, so the margin is
+  // whatever is left of the current interval.
+  int intervalPos = 0, intervalLen = 0;
+  client.GetPosition(&intervalPos, &intervalLen);
+  if (intervalLen > 0 && intervalPos < lastEncodeIntervalPos)
+  {
+    const auto rate = static_cast<double>(juce::jmax(1, sampleRate.load()));
+    encodeMarginMs = static_cast<float>((intervalLen - intervalPos) * 1000.0 / rate);
   }
+  lastEncodeIntervalPos = intervalPos;
+}
 
-  // ── Update meters ──
-  updateMetersFromBuffer(buffer);
-  const auto remote = client.GetOutputPeak();
+bool NinjamClientService::pollIntervalBoundary(juce::int64 nowTicks, bool& wrapped)
+{
+  // Interval-scoped changes (subscriptions, ...) are applied just after the
+  // server position wraps. If audio is not running the position never
+  // moves, so a stalled position also counts, once per stall period.
+  int intervalPos = 0, intervalLen = 0;
+  client.GetPosition(&intervalPos, &intervalLen);
+
+  wrapped = intervalPos < lastBoundaryIntervalPos;
+  bool stalled = false;
+  if (intervalPos != lastBoundaryIntervalPos)
   {
-    const juce::ScopedLock scopedLock(lock);
-    state.remoteMeter = clampMeter(state.remoteMeter * kRemoteMeterDecay + remote * (1.0f - kRemoteMeterDecay));
+    lastIntervalAdvanceTicks = nowTicks;
+  }
+  else if (juce::Time::highResolutionTicksToSeconds(nowTicks - lastIntervalAdvanceTicks) >= kIntervalStallSeconds)
+  {
+    lastIntervalAdvanceTicks = nowTicks;
+    stalled = true;
   }
+
+  lastBoundaryIntervalPos = intervalPos;
+  return wrapped || stalled;
 }
 
-// ─────────────────────────────────────────────────────────────────────────────
-// Settings
-// ─────────────────────────────────────────────────────────────────────────────
+void NinjamClientService::handleIntervalBoundary(bool wrapped)
+{
+  if (wrapped)
+    updateBitrateController();
+
+  if (unsubscribePending)
+  {
+    unsubscribePending = false;
+    applySubscriptionPolicy(true);
+  }
+}
 
-void NinjamClientService::setSampleRate(int sampleRateHz)
+void NinjamClientService::resetSessionTracking(juce::int64 nowTicks)
 {
-  sampleRate = juce::jmax(sampleRateHz, 1);
+  // Per-session statistics restart whenever a connection is established.
+  channelPlayback.clear();
+  peerJitterStats.clear();
+  jitterWindowStarts = 0;
+  jitterWindowLateStarts = 0;
+  jitterWindowDropouts = 0;
+  bitrateHistory.clear();
+  healthyBitrateIntervals = 0;
+  encodeBacklogIntervalPeak = 0;
+  encodeBacklogPeak = 0;
+  encodeBacklogSamples = 0;
+  encodeMarginMs = -1.0f;
+  lastEncodeIntervalPos = 0;
+  sessionStartTicks = nowTicks;
+  silentIntervalsSkipped = 0;
+  silentBytesSaved = 0;
 }
 
-void NinjamClientService::setMonitorMode(MonitorMode mode)
+void NinjamClientService::trackPlaybackStarts(juce::int64 nowTicks, bool wrapped)
 {
-  const juce::ScopedLock scopedLock(lock);
-  if (state.monitorMode == mode)
+  if (client.GetStatus() != NJClient::NJC_STATUS_OK)
     return;
 
-  state.monitorMode = mode;
-  switch (mode)
+  if (wrapped)
+    lastIntervalWrapTicks = nowTicks;
+  const double sinceWrapMs = juce::Time::highResolutionTicksToSeconds(nowTicks - lastIntervalWrapTicks) * 1000.0;
+
+  int activePerformers = 0;
+  const auto users = client.GetNumUsers();
+  for (int userIdx = 0; userIdx < users; ++userIdx)
+  {
+    const char* userName = client.GetUserState(userIdx);
+    if (userName == nullptr)
+      continue;
+    const juce::String name(userName);
+    bool performerActive = false;
+
+    for (int i = 0;; ++i)
+    {
+      const int chanIdx = client.EnumUserChannels(userIdx, i);
+      if (chanIdx < 0)
+        break;
+
+      bool subscribed = false;
+      if (client.GetUserChannelState(userIdx, chanIdx, &subscribed) == nullptr || !subscribed)
+        continue;
+
+      auto& playback = channelPlayback[name + "/" + juce::String(chanIdx)];
+      auto& stats = peerJitterStats[name];
+      const auto msSince = [nowTicks](juce::int64 ticks)
+      {
+        return juce::Time::highResolutionTicksToSeconds(nowTicks - ticks) * 1000.0;
+      };
+
+      // A whole interval below -80 dB counts as silent for that channel.
+      // Only a channel still playing when the interval ended is expected to
+      // continue after the wrap; one that had gone quiet may be resting.
+      if (wrapped)
+      {
+        if (playback.awaitingStart)
+          ++stats.histogram[startDelayBuckets - 1];
+        playback.awaitingStart = playback.audible && msSince(playback.lastAudibleTicks) <= kPlayedIntoWrapMs;
+        playback.audible = false;
+        playback.gapStartTicks = 0;
+
+        playback.lastIntervalSilent = playback.intervalPeak < kSilentIntervalPeak;
+        if (playback.lastIntervalSilent)
+          ++stats.silentIntervals;
+        playback.intervalPeak = 0.0f;
+      }
+      performerActive = performerActive || !playback.lastIntervalSilent;
+
+      const float peak = client.GetUserChannelPeak(userIdx, chanIdx);
+      playback.intervalPeak = juce::jmax(playback.intervalPeak, peak);
+      if (peak <= 0.0f)
+      {
+        if (playback.audible && playback.gapStartTicks == 0)
+          playback.gapStartTicks = nowTicks;
+        continue;
+      }
+
+      // Exact digital silence between two stretches of audio in the same
+      // interval is the decoder running dry; a rest is seldom this short.
+      if (playback.gapStartTicks != 0)
+      {
+        if (msSince(playback.gapStartTicks) <= kMaxDropoutMs)
+        {
+          ++stats.dropouts;
+          ++jitterWindowDropouts;
+        }
+        playback.gapStartTicks = 0;
+      }
+
+      playback.audible = true;
+      playback.lastAudibleTicks = nowTicks;
+      if (!playback.awaitingStart)
+        continue;
+
+      playback.awaitingStart = false;
+      const int bucket = sinceWrapMs < 20.0 ? 0 : sinceWrapMs < kLateStartMs ? 1 : sinceWrapMs < 500.0 ? 2 : 3;
+      ++stats.histogram[static_cast<size_t>(bucket)];
+      ++jitterWindowStarts;
+      if (sinceWrapMs >= kLateStartMs)
+      {
+        ++stats.lateStarts;
+        ++jitterWindowLateStarts;
+      }
+    }
+
+    if (performerActive)
+      ++activePerformers;
+  }
+
+  if (wrapped)
   {
-    case MonitorMode::IncomingOnly: appendLogLineUnlocked("Monitor mode: incoming only"); break;
-    case MonitorMode::AddLocal:     appendLogLineUnlocked("Monitor mode: add local"); break;
-    case MonitorMode::ListenLocal:  appendLogLineUnlocked("Monitor mode: listen local"); break;
+    activePerformerCount = activePerformers;
+    updatePrebufferController();
   }
 }
 
-NinjamClientService::MonitorMode NinjamClientService::getMonitorMode() const
+void NinjamClientService::setAdaptiveBitrate(bool enabled, int minKbps, int maxKbps)
 {
-  const juce::ScopedLock scopedLock(lock);
-  return state.monitorMode;
+  const juce::ScopedLock clientScope(clientLock);
+  adaptiveBitrateEnabled = enabled;
+  adaptiveBitrateMinKbps = juce::jlimit(kMinSendBitrateKbps, kMaxSendBitrateKbps, minKbps);
+  adaptiveBitrateMaxKbps = juce::jlimit(adaptiveBitrateMinKbps, kMaxSendBitrateKbps, maxKbps);
+  applySendBitrateCap(enabled ? juce::jlimit(adaptiveBitrateMinKbps, adaptiveBitrateMaxKbps,
+                                             sendBitrateCapKbps > 0 ? sendBitrateCapKbps : adaptiveBitrateMaxKbps)
+                              : 0);
 }
 
-void NinjamClientService::setMetronomeEnabled(bool enabled)
+int NinjamClientService::effectiveSendBitrate(int configuredKbps) const
 {
-  const juce::ScopedLock scopedLock(lock);
-  state.metronomeEnabled = enabled;
+  return sendBitrateCapKbps > 0 ? juce::jmin(configuredKbps, sendBitrateCapKbps) : configuredKbps;
 }
 
-bool NinjamClientService::getMetronomeEnabled() const
+void NinjamClientService::applySendBitrateCap(int capKbps)
 {
-  const juce::ScopedLock scopedLock(lock);
-  return state.metronomeEnabled;
+  // Caller holds clientLock. The talkback channel keeps its own bitrate.
+  sendBitrateCapKbps = capKbps;
+  for (const auto& [ch, configured] : configuredSendBitrates)
+  {
+    int srcch = 0, bitrate = 0;
+    bool broadcast = false;
+    const char* name = client.GetLocalChannelInfo(ch, &srcch, &bitrate, &broadcast);
+    if (name == nullptr)
+      continue;
+
+    const int wanted = effectiveSendBitrate(configured);
+    if (wanted != bitrate)
+      client.SetLocalChannelInfo(ch, juce::String(name).toRawUTF8(), false, 0, true, wanted, false, false);
+  }
 }
 
-void NinjamClientService::setLocalGain(float value)
+void NinjamClientService::setSilenceGate(bool enabled, float thresholdDb, float holdSeconds)
 {
-  const juce::ScopedLock scopedLock(lock);
-  state.localGain = juce::jlimit(0.0f, kGainMaxLinear, value);
+  silenceThresholdParam.store(juce::Decibels::decibelsToGain(juce::jlimit(-120.0f, 0.0f, thresholdDb)));
+  silenceHoldSecondsParam.store(juce::jmax(0.5f, holdSeconds));
+  silenceGateEnabledParam.store(enabled);
 }
 
-void NinjamClientService::setRemoteGain(float value)
+void NinjamClientService::updateSilenceGate(juce::int64 nowTicks, bool wrapped)
 {
-  const juce::ScopedLock scopedLock(lock);
-  state.remoteGain = juce::jlimit(0.0f, kGainMaxLinear, value);
-}
+  int intervalPos = 0, intervalLen = 0;
+  client.GetPosition(&intervalPos, &intervalLen);
 
-float NinjamClientService::getLocalGain() const
-{
-  const juce::ScopedLock scopedLock(lock);
-  return state.localGain;
-}
+  // Count the interval that just ended if it started gated: NJClient never
+  // uploaded it.
+  if (wrapped)
+  {
+    if (silenceGatedAtIntervalStart && intervalLen > 0)
+    {
+      const double intervalSeconds = intervalLen / static_cast<double>(juce::jmax(1, sampleRate.load()));
+      int kbps = 0;
+      for (const auto& entry : configuredSendBitrates)
+        kbps += effectiveSendBitrate(entry.second);
+      ++silentIntervalsSkipped;
+      silentBytesSaved += static_cast<juce::int64>(intervalSeconds * kbps * 1000.0 / 8.0);
+    }
+    silenceGatedAtIntervalStart = silenceGated;
+  }
 
-float NinjamClientService::getRemoteGain() const
-{
-  const juce::ScopedLock scopedLock(lock);
-  return state.remoteGain;
-}
+  bool wantGate = false;
+  if (silenceGateEnabledParam.load() && networkSessionConnected)
+  {
+    const auto lastAudible = juce::jmax(lastAudibleInputTicks.load(), sessionStartTicks);
+    wantGate = juce::Time::highResolutionTicksToSeconds(nowTicks - lastAudible) >= silenceHoldSecondsParam.load();
+  }
 
-void NinjamClientService::setPhaseOffsetMs(float ms)
-{
-  const juce::ScopedLock scopedLock(lock);
-  state.phaseOffsetMs = juce::jlimit(-500.0f, 500.0f, ms);
-}
+  if (wantGate == silenceGated)
+    return;
 
-void NinjamClientService::setUserChannelMute(int userIdx, int channelIdx, bool mute)
-{
-  client.SetUserChannelState(userIdx, channelIdx,
-                             false, false, false, 0.0f, false, 0.0f,
-                             true, mute, false, false);
+  silenceGated = wantGate;
+  for (const auto& entry : configuredSendBitrates)
+  {
+    int srcch = 0, bitrate = 0;
+    bool broadcast = false;
+    const char* name = client.GetLocalChannelInfo(entry.first, &srcch, &bitrate, &broadcast);
+    if (name != nullptr)
+      client.SetLocalChannelInfo(entry.first, juce::String(name).toRawUTF8(), false, 0, false, 0, true, !wantGate);
+  }
+  postEvent(ServiceEvent::Type::SilenceGateChanged, wantGate ? 1 : 0);
 }
 
-void NinjamClientService::setUserChannelSolo(int userIdx, int channelIdx, bool solo)
+void NinjamClientService::updateBitrateController()
 {
-  client.SetUserChannelState(userIdx, channelIdx,
-                             false, false, false, 0.0f, false, 0.0f,
-                             false, false, true, solo);
-}
+  // Runs at each server interval wrap. This adapts to encode load, not to
+  // the network: NJClient does not expose its socket or send queue, so the
+  // only signals are an encode backlog that built up during the interval
+  // and the previous interval's encode finishing close to the wrap.
+  const int backlogPeak = encodeBacklogIntervalPeak;
+  encodeBacklogIntervalPeak = 0;
+
+  if (!adaptiveBitrateEnabled || configuredSendBitrates.empty())
+    return;
 
-void NinjamClientService::setUserChannelVolume(int userIdx, int channelIdx, float volume)
-{
-  client.SetUserChannelState(userIdx, channelIdx,
-                             false, false, true, juce::jlimit(0.0f, kGainMaxLinear, volume),
-                             false, 0.0f, false, false, false, false);
-}
+  int intervalPos = 0, intervalLen = 0;
+  client.GetPosition(&intervalPos, &intervalLen);
+  const double rate = static_cast<double>(juce::jmax(1, sampleRate.load()));
+  const double intervalMs = intervalLen * 1000.0 / rate;
+  if (intervalMs <= 0.0)
+    return;
 
-float NinjamClientService::getPhaseOffsetMs() const
-{
-  const juce::ScopedLock scopedLock(lock);
-  return state.phaseOffsetMs;
+  // Until an interval of this session has finished encoding there is no
+  // margin to judge, only the backlog.
+  const bool marginMeasured = encodeMarginMs >= 0.0f;
+  const bool overloaded = (marginMeasured && encodeMarginMs < intervalMs * kEncodeOverloadMarginFraction)
+                      || backlogPeak > static_cast<int>(rate * kEncodeOverloadBacklogSeconds);
+
+  int ceiling = adaptiveBitrateMinKbps;
+  for (const auto& entry : configuredSendBitrates)
+    ceiling = juce::jmax(ceiling, entry.second);
+  ceiling = juce::jmin(ceiling, adaptiveBitrateMaxKbps);
+
+  const int current = sendBitrateCapKbps > 0 ? juce::jmin(sendBitrateCapKbps, ceiling) : ceiling;
+  int next = current;
+  if (overloaded)
+  {
+    healthyBitrateIntervals = 0;
+    for (const int step : kBitrateLadderKbps)
+    {
+      if (step < current)
+        next = step;
+    }
+    next = juce::jmax(next, adaptiveBitrateMinKbps);
+  }
+  else if (++healthyBitrateIntervals >= kBitrateStepUpIntervals)
+  {
+    healthyBitrateIntervals = 0;
+    for (const int step : kBitrateLadderKbps)
+    {
+      if (step > current)
+      {
+        next = step;
+        break;
+      }
+    }
+    next = juce::jmin(next, ceiling);
+  }
+
+  if (next == current && sendBitrateCapKbps > 0)
+    return;
+
+  applySendBitrateCap(next);
+  if (next == current)
+    return;
+
+  BitrateChange change;
+  change.sessionSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - sessionStartTicks);
+  change.bitrateKbps = next;
+  change.encodeOverloaded = overloaded;
+  if (bitrateHistory.size() >= kMaxBitrateHistory)
+    bitrateHistory.erase(bitrateHistory.begin());
+  bitrateHistory.push_back(change);
+  postEvent(ServiceEvent::Type::BitrateChanged, next);
 }
 
-NinjamClientService::Snapshot NinjamClientService::getSnapshot() const
+void NinjamClientService::updatePrebufferController()
 {
-  const juce::ScopedLock scopedLock(lock);
-  return state;
+  // NJClient holds a remote interval back until config_play_prebuffer bytes
+  // of it have arrived. A late start means that asked for more than had
+  // arrived by the wrap: halve it. A dropout means the decoder caught up
+  // with the download mid-interval, which a larger head start absorbs:
+  // double it, up to kMaxPrebufferBytes. Both at once is a link short of
+  // bandwidth that no prebuffer fixes, so it holds. A clean window steps a
+  // lowered prebuffer back up to the default.
+  const bool windowFull = jitterWindowStarts >= kJitterWindowStarts;
+  if (!windowFull && jitterWindowLateStarts < kJitterFastReactEvents && jitterWindowDropouts < kJitterFastReactEvents)
+    return;
+
+  const double starts = static_cast<double>(juce::jmax(1, jitterWindowStarts));
+  const double lateRate = static_cast<double>(jitterWindowLateStarts) / starts;
+  const double dropoutRate = static_cast<double>(jitterWindowDropouts) / starts;
+  const bool tooManyLate = jitterWindowLateStarts > 0 && lateRate > kTargetLateStartRate;
+  const bool tooManyDropouts = jitterWindowDropouts > 0 && dropoutRate > kTargetDropoutRate;
+
+  int newPrebuffer = playPrebufferBytes;
+  if (tooManyLate && !tooManyDropouts)
+    newPrebuffer = juce::jmax(kMinPrebufferBytes, playPrebufferBytes / 2);
+  else if (tooManyDropouts && !tooManyLate)
+    newPrebuffer = juce::jmin(kMaxPrebufferBytes, playPrebufferBytes * 2);
+  else if (!tooManyLate && windowFull && lateRate <= kTargetLateStartRate * 0.25 && playPrebufferBytes < kInitialPrebufferBytes)
+    newPrebuffer = juce::jmin(kInitialPrebufferBytes, playPrebufferBytes * 2);
+
+  jitterWindowStarts = 0;
+  jitterWindowLateStarts = 0;
+  jitterWindowDropouts = 0;
+
+  if (newPrebuffer != playPrebufferBytes)
+  {
+    playPrebufferBytes = newPrebuffer;
+    client.config_play_prebuffer = newPrebuffer;
+    postEvent(ServiceEvent::Type::PrebufferChanged, newPrebuffer);
+  }
 }
 
-void NinjamClientService::addLogLine(const juce::String& message)
+void NinjamClientService::applySubscriptionPolicy(bool allowUnsubscribe)
 {
-  const juce::ScopedLock scopedLock(lock);
-  appendLogLineUnlocked(message);
-}
+  if (client.GetStatus() != NJClient::NJC_STATUS_OK)
+  {
+    subscribedChannelCount = 0;
+    skippedChannelCount = 0;
+    return;
+  }
 
-// ─────────────────────────────────────────────────────────────────────────────
-// Timer / polling
-// ─────────────────────────────────────────────────────────────────────────────
+  const auto policy = static_cast<SubscriptionPolicy>(subscriptionPolicyParam.load());
+  const int maxSubscriptions = maxSubscriptionsParam.load();
+  juce::StringArray priority;
+  {
+    const juce::ScopedLock scopedLock(lock);
+    priority = subscriptionPriority;
+  }
 
-void NinjamClientService::timerCallback()
-{
-  for (int i = 0; i < 8; ++i)
+  struct Candidate
   {
-    if (client.Run())
-      break;
+    int userIdx = 0;
+    int chanIdx = 0;
+    int rank = 0;
+    bool subscribed = false;
+    bool muted = false;
+    bool solo = false;
+    bool wanted = false;
+  };
+
+  std::vector<Candidate> candidates;
+  bool anySolo = false;
+  const auto users = client.GetNumUsers();
+  for (int userIdx = 0; userIdx < users; ++userIdx)
+  {
+    const char* userName = client.GetUserState(userIdx);
+    const int listed = userName != nullptr ? priority.indexOf(juce::String(userName)) : -1;
+
+    for (int i = 0;; ++i)
+    {
+      const int chanIdx = client.EnumUserChannels(userIdx, i);
+      if (chanIdx < 0)
+        break;
+
+      Candidate c;
+      c.userIdx = userIdx;
+      c.chanIdx = chanIdx;
+      c.rank = listed >= 0 ? listed : priority.size();
+      if (client.GetUserChannelState(userIdx, chanIdx, &c.subscribed, nullptr, nullptr, &c.muted, &c.solo) == nullptr)
+        continue;
+
+      anySolo = anySolo || c.solo;
+      candidates.push_back(c);
+    }
   }
 
-  if (client.HasUserInfoChanged() != 0)
+  for (auto& c : candidates)
   {
-    ensureAllRemoteChannelsSubscribed();
-    warnIfDuplicateUsername();
+    if (policy == SubscriptionPolicy::All)
+      c.wanted = true;
+    else if (policy == SubscriptionPolicy::SoloAware && anySolo)
+      c.wanted = c.solo;
+    else
+      c.wanted = !c.muted;
+  }
+
+  // Over the cap, soloed channels win, then the priority list order, then
+  // join order.
+  if (maxSubscriptions > 0)
+  {
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b)
+    {
+      if (a.solo != b.solo)
+        return a.solo;
+      return a.rank < b.rank;
+    });
+
+    int granted = 0;
+    for (auto& c : candidates)
+    {
+      if (c.wanted && granted++ >= maxSubscriptions)
+        c.wanted = false;
+    }
+  }
+
+  int active = 0;
+  int changed = 0;
+  for (const auto& c : candidates)
+  {
+    bool subscribed = c.subscribed;
+    if (c.wanted != subscribed && (c.wanted || allowUnsubscribe))
+    {
+      client.SetUserChannelState(c.userIdx, c.chanIdx,
+                                 true, c.wanted, false, 0.0f, false, 0.0f,
+                                 false, false, false, false);
+      subscribed = c.wanted;
+      ++changed;
+    }
+    if (subscribed)
+      ++active;
   }
 
-  refreshStatusFromCore();
+  subscribedChannelCount = active;
+  skippedChannelCount = static_cast<int>(candidates.size()) - active;
+  if (changed > 0)
+    postEvent(ServiceEvent::Type::SubscriptionsChanged, active);
 }
 
-void NinjamClientService::ensureAllRemoteChannelsSubscribed()
+void NinjamClientService::routeRemoteChannels()
 {
+  const int numSlots = stemSlotCount.load();
+  const bool voiceOutput = voiceOutputAvailable.load();
+  const int voiceOutch = kMaxAudioChannels + kStemChannels * numSlots;
+  while (stemSlotUsers.size() < numSlots)
+    stemSlotUsers.add({});
+  stemSlotUsers.removeRange(numSlots, stemSlotUsers.size() - numSlots);
+
   if (client.GetStatus() != NJClient::NJC_STATUS_OK)
     return;
 
+  juce::StringArray present;
   const auto users = client.GetNumUsers();
   for (int userIdx = 0; userIdx < users; ++userIdx)
   {
+    const char* name = client.GetUserState(userIdx);
+    present.add(name != nullptr ? juce::String(name) : juce::String());
+  }
+
+  for (int userIdx = 0; userIdx < users; ++userIdx)
+  {
+    const auto& name = present[userIdx];
+    int slot = name.isNotEmpty() ? stemSlotUsers.indexOf(name) : -1;
+
+    // A new user takes a never-used slot first, then one whose previous
+    // owner has left; when all are taken they stay on the main output.
+    if (slot < 0 && name.isNotEmpty())
+    {
+      slot = stemSlotUsers.indexOf(juce::String());
+      for (int i = 0; slot < 0 && i < numSlots; ++i)
+      {
+        if (!present.contains(stemSlotUsers[i]))
+          slot = i;
+      }
+      if (slot >= 0)
+        stemSlotUsers.set(slot, name);
+    }
+
+    if (slot >= 0)
+      ensureStemRing(slot);
+
+    const int userOutch = slot >= 0 ? kMaxAudioChannels + kStemChannels * slot : 0;
     for (int i = 0;; ++i)
     {
       const int chanIdx = client.EnumUserChannels(userIdx, i);
       if (chanIdx < 0)
         break;
 
-      bool subscribed = true;
-      if (client.GetUserChannelState(userIdx, chanIdx, &subscribed) == nullptr)
-        continue;
+      int flags = 0;
+      client.GetUserChannelState(userIdx, chanIdx, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &flags);
+      const int outch = (voiceOutput && (flags & kVoiceChatFlag) != 0) ? voiceOutch : userOutch;
 
-      if (!subscribed)
-      {
-        client.SetUserChannelState(userIdx, chanIdx,
-                                   true, true, true, 1.0f, false, 0.0f,
-                                   false, false, false, false, false, 0);
-      }
+      client.SetUserChannelState(userIdx, chanIdx,
+                                 false, false, false, 0.0f, false, 0.0f,
+                                 false, false, false, false, true, outch);
     }
   }
 }
 
+void NinjamClientService::ensureStemRing(int slot)
+{
+  // Runs before the user is routed to the slot, so the ring is in place
+  // by the first block NJClient renders there. Until prepare() has sized
+  // the main ring there is no geometry to copy; prepare() reroutes.
+  const int capacity = phaseRingBuffer.getCapacity();
+  if (capacity == 0 || stemRingReady[slot].load(std::memory_order_relaxed))
+    return;
+
+  stemRings[slot].allocate(kStemChannels, capacity, phaseRingBuffer.isCompact());
+  stemRingReady[slot].store(true, std::memory_order_release);
+  publishRingStorageBytes();
+}
+
+void NinjamClientService::publishRingStorageBytes()
+{
+  // Every ring allocation holds clientLock, as the callers do.
+  auto bytes = phaseRingBuffer.getStorageBytes() + inputRingBuffer.getStorageBytes();
+  for (const auto& ring : stemRings)
+    bytes += ring.getStorageBytes();
+  ringStorageBytes.store(static_cast<juce::int64>(bytes));
+}
+
 void NinjamClientService::warnIfDuplicateUsername()
 {
   if (client.GetStatus() != NJClient::NJC_STATUS_OK)
@@ -714,37 +1848,47 @@ void NinjamClientService::refreshStatusFromCore()
   const auto bpm = juce::roundToInt(client.GetActualBPM());
   const auto bpi = client.GetBPI();
 
+  const bool hostLocked = hostLockedActive.load();
+  const bool hostBpmValid = lastHostBpmValid.load();
+  const double hostBpm = lastHostBpm.load();
+  const bool hostPpqValid = lastHostPpqValid.load();
+  const double hostPpq = lastHostPpq.load();
+
   const juce::ScopedLock scopedLock(lock);
   state.connected = (statusCode == NJClient::NJC_STATUS_OK);
   state.statusText = statusCodeToText(statusCode);
 
   if (bpm > 0 && lastServerBpm > 0 && bpm != lastServerBpm)
   {
-    forceSeekPending = true;
-    appendLogLineUnlocked("Server BPM changed to " + juce::String(bpm) + ", scheduling resync");
+    forceSeekPending.store(true);
+    postEvent(ServiceEvent::Type::BpmChanged, bpm);
+    postEvent(ServiceEvent::Type::ResyncScheduled, 0);
   }
   if (bpi > 0 && lastServerBpi > 0 && bpi != lastServerBpi)
   {
-    forceSeekPending = true;
-    appendLogLineUnlocked("Server BPI changed to " + juce::String(bpi) + ", scheduling resync");
+    forceSeekPending.store(true);
+    postEvent(ServiceEvent::Type::BpiChanged, bpi);
+    postEvent(ServiceEvent::Type::ResyncScheduled, 0);
   }
   if (bpm > 0) lastServerBpm = bpm;
   if (bpi > 0) lastServerBpi = bpi;
 
   if (bpm > 0) state.serverBpm = bpm;
-  state.hostBpmValid = lastHostBpmValid;
-  state.hostBpm = lastHostBpmValid ? juce::roundToInt(lastHostBpm) : 0;
+  state.hostBpmValid = hostBpmValid;
+  state.hostBpm = hostBpmValid ? juce::roundToInt(hostBpm) : 0;
 
-  if (hostLockedActive && lastHostBpmValid)
-    state.bpm = juce::roundToInt(lastHostBpm);
+  if (hostLocked && hostBpmValid)
+    state.bpm = juce::roundToInt(hostBpm);
   else if (bpm > 0)
     state.bpm = bpm;
   if (bpi > 0) state.bpi = bpi;
+  sessionBpmParam.store(state.bpm);
+  roomBpiParam.store(state.bpi);
 
-  if (hostLockedActive && lastHostPpqValid && state.bpi > 0)
+  if (hostLocked && hostPpqValid && state.bpi > 0)
   {
     const auto bpiD = static_cast<double>(state.bpi);
-    auto beatInInterval = std::fmod(lastHostPpq, bpiD);
+    auto beatInInterval = std::fmod(hostPpq, bpiD);
     if (beatInInterval < 0.0) beatInInterval += bpiD;
     state.intervalProgress = clampMeter(static_cast<float>(beatInInterval / bpiD));
   }
@@ -755,7 +1899,7 @@ void NinjamClientService::refreshStatusFromCore()
 
   if (statusCode != lastStatusCode)
   {
-    appendLogLineUnlocked("Status: " + state.statusText);
+    postEvent(ServiceEvent::Type::StatusChanged, statusCode);
     lastStatusCode = statusCode;
   }
 
@@ -773,6 +1917,16 @@ void NinjamClientService::refreshStatusFromCore()
       RemoteUser user;
       user.name = juce::String(userName);
       user.userIndex = u;
+      user.stemSlot = stemSlotUsers.indexOf(user.name);
+
+      const auto jitter = peerJitterStats.find(user.name);
+      if (jitter != peerJitterStats.end())
+      {
+        user.lateStarts = jitter->second.lateStarts;
+        user.dropouts = jitter->second.dropouts;
+        user.silentIntervals = jitter->second.silentIntervals;
+        user.startDelayHistogram = jitter->second.histogram;
+      }
 
       for (int i = 0;; ++i)
       {
@@ -790,6 +1944,10 @@ void NinjamClientService::refreshStatusFromCore()
         ch.volume = vol;
         ch.muted = muted;
         ch.solo = solo;
+        ch.subscribed = sub;
+
+        const auto playback = channelPlayback.find(user.name + "/" + juce::String(chanIdx));
+        ch.lastIntervalSilent = playback != channelPlayback.end() && playback->second.lastIntervalSilent;
         ch.peak = clampMeter(client.GetUserChannelPeak(u, chanIdx));
         user.channels.push_back(ch);
       }
@@ -798,65 +1956,174 @@ void NinjamClientService::refreshStatusFromCore()
     }
   }
 
-  if (!state.connected)
+  // Pull meters from the audio thread; decay them if it has gone quiet while disconnected.
+  const auto pullMeter = [this](const MeterSlot& slot, uint32_t& lastSequence, float& value)
+  {
+    const auto sequence = slot.getSequence();
+    if (sequence != lastSequence)
+    {
+      lastSequence = sequence;
+      value = slot.read();
+    }
+    else if (!state.connected)
+    {
+      value *= 0.9f;
+    }
+  };
+  pullMeter(localMeterSlot, lastLocalMeterSequence, state.localMeter);
+  pullMeter(remoteMeterSlot, lastRemoteMeterSequence, state.remoteMeter);
+  pullMeter(sendMeterSlot, lastSendMeterSequence, state.sendMeter);
+
+  state.networkDutyCycle = networkDutyCycle;
+  state.networkWakeJitterMs = networkWakeJitterMs;
+
+  const auto worstMs = static_cast<float>(
+    juce::Time::highResolutionTicksToSeconds(worstBlockTicks.exchange(0)) * 1000.0);
+  state.audioBlockWorstMs = juce::jmax(worstMs, state.audioBlockWorstMs * 0.95f);
+
+  const auto mixWorstMs = static_cast<float>(
+    juce::Time::highResolutionTicksToSeconds(worstAudioProcTicks.exchange(0)) * 1000.0);
+  state.remoteMixWorstMs = juce::jmax(mixWorstMs, state.remoteMixWorstMs * 0.95f);
+
+  const int overruns = audioProcOverruns.load();
+  if (overruns != lastReportedAudioProcOverruns)
   {
-    state.localMeter *= 0.9f;
-    state.remoteMeter *= 0.9f;
-    state.sendMeter *= 0.9f;
+    postEvent(ServiceEvent::Type::RemoteMixOverrun, overruns - lastReportedAudioProcOverruns);
+    lastReportedAudioProcOverruns = overruns;
   }
+  state.remoteMixOverruns = overruns;
+
+  state.talkbackSendLatencyMs = talkbackSendLatencyPeakMs;
+  talkbackSendLatencyPeakMs = 0.0f;
+
+  state.playPrebufferBytes = playPrebufferBytes;
+  state.sendBitrateCapKbps = sendBitrateCapKbps;
+  state.silenceGateActive = silenceGated;
+  state.silentIntervalsSkipped = silentIntervalsSkipped;
+  state.silentBytesSaved = silentBytesSaved;
+  state.bitrateHistory = bitrateHistory;
+  state.decodersActive = state.connected ? subscribedChannelCount : 0;
+  state.activePerformers = state.connected ? activePerformerCount : 0;
+  state.channelsSkipped = state.connected ? skippedChannelCount : 0;
+  state.bandwidthSavedKbps = state.channelsSkipped * kEstimatedRemoteChannelKbps;
+
+  // NJClient encodes every local channel in the same Run() pass, so the
+  // backlog and margin are one figure for the whole encoder, not per channel.
+  encodeBacklogSamples = encodeBacklogPeak;
+  encodeBacklogPeak = 0;
+  state.encodeBacklogSamples = encodeBacklogSamples;
+  state.encodeMarginMs = encodeMarginMs;
+  state.localChannelCount = 0;
+  while (client.EnumLocalChannels(state.localChannelCount) >= 0)
+    ++state.localChannelCount;
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
-// Metering
+// Event queue
 // ─────────────────────────────────────────────────────────────────────────────
 
-void NinjamClientService::updateMetersFromBuffer(const juce::AudioBuffer<float>& buffer)
+void NinjamClientService::postEvent(ServiceEvent::Type type, int value) noexcept
 {
-  const auto numCh = juce::jmin(2, buffer.getNumChannels());
-  if (numCh <= 0 || buffer.getNumSamples() <= 0)
-  {
-    state.localMeter = 0.0f;
-    return;
-  }
+  ServiceEvent event;
+  event.type = type;
+  event.value = value;
+  eventQueue.tryPush(event);
+}
 
-  auto peak = 0.0f;
-  for (int ch = 0; ch < numCh; ++ch)
-    peak = juce::jmax(peak, buffer.getMagnitude(ch, 0, buffer.getNumSamples()));
+void NinjamClientService::drainEvents()
+{
+  const auto dropped = static_cast<int>(eventQueue.takeDroppedCount());
 
   const juce::ScopedLock scopedLock(lock);
-  state.localMeter = clampMeter(peak);
+  ServiceEvent event;
+  while (eventQueue.tryPop(event))
+  {
+    switch (event.type)
+    {
+      case ServiceEvent::Type::SyncModeChanged:
+        appendLogLineUnlocked("Sync: " + syncModeToText(event.value));
+        break;
+      case ServiceEvent::Type::ResyncScheduled:
+        appendLogLineUnlocked("Resync scheduled");
+        break;
+      case ServiceEvent::Type::SyncAligned:
+        appendLogLineUnlocked("Aligned to host beats " + juce::String(event.value) + " ms after resync");
+        break;
+      case ServiceEvent::Type::BpmChanged:
+        appendLogLineUnlocked("Server BPM changed to " + juce::String(event.value));
+        break;
+      case ServiceEvent::Type::BpiChanged:
+        appendLogLineUnlocked("Server BPI changed to " + juce::String(event.value));
+        break;
+      case ServiceEvent::Type::StatusChanged:
+        appendLogLineUnlocked("Status: " + statusCodeToText(event.value));
+        break;
+      case ServiceEvent::Type::RingCapacityExceeded:
+        appendLogLineUnlocked("Warning: interval of " + juce::String(event.value)
+                              + " samples exceeds the preallocated phase ring; host alignment bypassed");
+        break;
+      case ServiceEvent::Type::SilenceGateChanged:
+        appendLogLineUnlocked(event.value != 0 ? "Input silent: pausing upload from the next interval"
+                                               : "Input active: resuming upload");
+        break;
+      case ServiceEvent::Type::BitrateChanged:
+        appendLogLineUnlocked("Encode load: send bitrate cap set to " + juce::String(event.value) + " kbps");
+        break;
+      case ServiceEvent::Type::PrebufferChanged:
+        appendLogLineUnlocked("Playback prebuffer adjusted to " + juce::String(event.value) + " bytes");
+        break;
+      case ServiceEvent::Type::SubscriptionsChanged:
+        appendLogLineUnlocked("Subscriptions updated: "
+                              + juce::String(event.value) + " channel(s) active");
+        break;
+      case ServiceEvent::Type::RemoteMixOverrun:
+        appendLogLineUnlocked("Warning: remote decode/mix exceeded its audio budget in " + juce::String(event.value)
+                              + " block(s); consider muting or unsubscribing channels");
+        break;
+    }
+  }
+
+  if (dropped > 0)
+  {
+    state.droppedEvents += dropped;
+    appendLogLineUnlocked("Warning: " + juce::String(dropped) + " service events dropped (queue full)");
+  }
 }
 
+// ─────────────────────────────────────────────────────────────────────────────
+// Metering
+// ─────────────────────────────────────────────────────────────────────────────
+
+float NinjamClientService::measurePeak(const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples)
+{
+  auto peak = 0.0f;
+  for (int ch = 0; ch < numChannels; ++ch)
+    peak = juce::jmax(peak, buffer.getMagnitude(ch, 0, numSamples));
+  return peak;
+}
 float NinjamClientService::clampMeter(float value)
 {
   return juce::jlimit(0.0f, 1.0f, value);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
-// Ring buffer helper
+// Audio-thread sync state
 // ─────────────────────────────────────────────────────────────────────────────
 
-void NinjamClientService::ringCopy(juce::AudioBuffer<float>& dst, int dstPos,
-                                   const juce::AudioBuffer<float>& src, int srcPos,
-                                   int numChannels, int numSamples, int ringLen)
+void NinjamClientService::resetSyncStateForAudioThread()
 {
-  if (srcPos + numSamples <= ringLen && dstPos + numSamples <= dst.getNumSamples())
-  {
-    for (int ch = 0; ch < numChannels; ++ch)
-      dst.copyFrom(ch, dstPos, src, ch, srcPos, numSamples);
-  }
-  else
+  lastSyncMode = -1;
+  hostClock.reset();
+  phaseRingBuffer.restartFill();
+  inputRingBuffer.restartFill();
+  for (int slot = 0; slot < maxStemOutputs; ++slot)
   {
-    const int srcWrap = ringLen;
-    const int dstWrap = dst.getNumSamples();
-    for (int i = 0; i < numSamples; ++i)
-    {
-      const int si = (srcPos + i) % srcWrap;
-      const int di = (dstPos + i) % dstWrap;
-      for (int ch = 0; ch < numChannels; ++ch)
-        dst.getWritePointer(ch)[di] = src.getReadPointer(ch)[si];
-    }
+    if (stemRingReady[slot].load(std::memory_order_acquire))
+      stemRings[slot].restartFill();
   }
+  directStallSamples = 0;
+  directAdvanceSamples = 0;
+  resyncElapsedSamples = -1;
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -964,6 +2231,17 @@ juce::String NinjamClientService::statusCodeToText(int statusCode)
   }
 }
 
+juce::String NinjamClientService::syncModeToText(int syncMode)
+{
+  switch (syncMode)
+  {
+    case syncHostLocked:      return "Host Locked";
+    case syncFallbackStopped: return "Fallback (Host Stopped)";
+    case syncFallbackNoClock: return "Fallback (No Host Clock)";
+    default:                  return "Classic";
+  }
+}
+
 void NinjamClientService::applySessionChannelModeToCore()
 {
   int srcch = 0, bitrate = 96, outch = 0, flags = 0;
@@ -998,38 +2276,150 @@ void NinjamClientService::applySessionChannelModeToCore()
 // ─────────────────────────────────────────────────────────────────────────────
 
 void NinjamClientService::renderMetronome(float** outBuffers, int numChannels, int blockSize,
-                                          double bpm, int bpi, double phaseBeats, int sampleRateHz)
+                                          double bpm, int bpi, double phaseBeats, int sampleRateHz, float gain)
 {
-  const int clickLen = sampleRateHz / 100;
-  const double sc = 6000.0 / static_cast<double>(sampleRateHz);
+  const juce::SpinLock::ScopedTryLockType clicksScope(metronomeClicksLock);
+  if (!clicksScope.isLocked() || metronomeClicks == nullptr)
+    return;
+
+  const auto& clicks = *metronomeClicks;
   const double beatInc = bpm / (60.0 * static_cast<double>(sampleRateHz));
-  const double metroVol = static_cast<double>(client.config_metronome);
+  const float metroVol = client.config_metronome * gain;
 
-  for (int x = 0; x < blockSize; ++x)
+  // Continue the click in progress over [start, end).
+  const auto mixClick = [&](int start, int end)
   {
-    const double beatNow = phaseBeats + static_cast<double>(x) * beatInc;
-    const int beatNowInt = static_cast<int>(std::floor(beatNow + 1.0e-12));
-    const int beatPrevInt = static_cast<int>(std::floor(beatNow - beatInc + 1.0e-12));
+    if (metronomeClickPos < 0)
+      return;
+
+    const auto& table = metronomeClickAccent ? clicks.accent : clicks.normal;
+    const int count = juce::jmin(end - start, static_cast<int>(table.size()) - metronomeClickPos);
+    if (count > 0)
+    {
+      for (int ch = 0; ch < numChannels; ++ch)
+        juce::FloatVectorOperations::addWithMultiply(outBuffers[ch] + start, table.data() + metronomeClickPos,
+                                                     metroVol, count);
+      metronomeClickPos += count;
+    }
+
+    if (metronomeClickPos >= static_cast<int>(table.size()))
+      metronomeClickPos = -1;
+  };
 
-    if (beatNowInt != beatPrevInt)
+  int pos = 0;
+  if (beatInc > 0.0)
+  {
+    // First whole beat crossed at or after sample 0, then each following
+    // crossing located directly instead of testing every sample.
+    double nextBeat = std::floor(phaseBeats - beatInc + 1.0e-12) + 1.0;
+    for (;;)
     {
-      metronomeClickState = 1;
-      int beatInInterval = beatNowInt % bpi;
+      const double crossing = std::ceil((nextBeat - 1.0e-12 - phaseBeats) / beatInc);
+      if (crossing >= static_cast<double>(blockSize))
+        break;
+
+      const int x = juce::jmax(pos, static_cast<int>(crossing));
+      mixClick(pos, x);
+      pos = x;
+
+      auto beatInInterval = static_cast<juce::int64>(nextBeat) % bpi;
       if (beatInInterval < 0) beatInInterval += bpi;
       metronomeClickAccent = (beatInInterval == 0);
+      metronomeClickPos = 0;
+      nextBeat += 1.0;
     }
+  }
 
-    if (metronomeClickState > 0)
-    {
-      const double val = metronomeClickAccent
-        ? std::sin(static_cast<double>(metronomeClickState) * sc) * metroVol
-        : std::sin(static_cast<double>(metronomeClickState) * sc * 2.0) * 0.25 * metroVol;
+  mixClick(pos, blockSize);
+}
 
-      for (int ch = 0; ch < numChannels; ++ch)
-        outBuffers[ch][x] += static_cast<float>(val);
+void NinjamClientService::rebuildMetronomeClicks(int sampleRateHz)
+{
+  auto cache = std::make_unique<MetronomeClickCache>();
+  cache->sampleRateHz = sampleRateHz;
+
+  // Built-in 10 ms tones: accent, and a quieter normal click an octave up.
+  const int clickLen = sampleRateHz / 100;
+  const double sc = 6000.0 / static_cast<double>(sampleRateHz);
+  const auto renderTone = [clickLen, sc](std::vector<float>& table, double freqScale, double level)
+  {
+    table.resize(static_cast<size_t>(juce::jmax(0, clickLen - 1)));
+    for (size_t i = 0; i < table.size(); ++i)
+      table[i] = static_cast<float>(std::sin(static_cast<double>(i + 1) * sc * freqScale) * level);
+  };
 
-      if (++metronomeClickState >= clickLen)
-        metronomeClickState = 0;
+  // Linear-interpolated conversion of a user sample to the current rate.
+  const auto renderSample = [sampleRateHz](std::vector<float>& table, const juce::AudioBuffer<float>& source, double sourceRate)
+  {
+    const double ratio = sourceRate / static_cast<double>(sampleRateHz);
+    const int sourceLen = source.getNumSamples();
+    const int len = static_cast<int>(static_cast<double>(sourceLen) / ratio);
+    const auto* src = source.getReadPointer(0);
+    table.resize(static_cast<size_t>(juce::jmax(0, len)));
+    for (int i = 0; i < len; ++i)
+    {
+      const double srcPos = static_cast<double>(i) * ratio;
+      const int i0 = static_cast<int>(srcPos);
+      const int i1 = juce::jmin(i0 + 1, sourceLen - 1);
+      const auto frac = static_cast<float>(srcPos - static_cast<double>(i0));
+      table[static_cast<size_t>(i)] = src[i0] + (src[i1] - src[i0]) * frac;
     }
+  };
+
+  {
+    const juce::ScopedLock scopedLock(lock);
+    if (customAccentClick.getNumSamples() > 0)
+      renderSample(cache->accent, customAccentClick, customAccentClickRate);
+    else
+      renderTone(cache->accent, 1.0, 1.0);
+
+    if (customNormalClick.getNumSamples() > 0)
+      renderSample(cache->normal, customNormalClick, customNormalClickRate);
+    else
+      renderTone(cache->normal, 2.0, 0.25);
+  }
+
+  {
+    const juce::SpinLock::ScopedLockType clicksScope(metronomeClicksLock);
+    std::swap(metronomeClicks, cache);
+    metronomeClickPos = -1;
+  }
+}
+
+bool NinjamClientService::setMetronomeSamples(const juce::File& accentFile, const juce::File& normalFile)
+{
+  juce::AudioFormatManager formatManager;
+  formatManager.registerBasicFormats();
+
+  // An empty or unreadable file falls back to the built-in tone.
+  const auto readClick = [&formatManager](const juce::File& file, juce::AudioBuffer<float>& dest, double& rate)
+  {
+    dest.setSize(1, 0);
+    rate = 0.0;
+    if (!file.existsAsFile())
+      return file == juce::File();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->sampleRate <= 0.0)
+      return false;
+
+    const auto maxLen = static_cast<juce::int64>(kMaxCustomClickSeconds * reader->sampleRate);
+    const auto len = static_cast<int>(juce::jmin(reader->lengthInSamples, maxLen));
+    dest.setSize(1, len);
+    reader->read(&dest, 0, len, 0, true, false);
+    rate = reader->sampleRate;
+    return true;
+  };
+
+  bool ok = true;
+  {
+    const juce::ScopedLock scopedLock(lock);
+    ok &= readClick(accentFile, customAccentClick, customAccentClickRate);
+    ok &= readClick(normalFile, customNormalClick, customNormalClickRate);
+    if (!ok)
+      appendLogLineUnlocked("Warning: could not read metronome sample; using built-in click");
   }
+
+  rebuildMetronomeClicks(sampleRate.load());
+  return ok;
 }
@@ -2,8 +2,20 @@
 
 #include <JuceHeader.h>
 #include "njclient.h"
+#include "AudioKernels.h"
+#include "IntervalRing.h"
+#include "MeterSlot.h"
+#include "PhaseRings.h"
+#include "RealtimeEventQueue.h"
+#include "SampleClock.h"
 
-class NinjamClientService : private juce::Timer
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+
+class NinjamClientService : private juce::Timer,
+                            private juce::Thread
 {
 public:
   enum class MonitorMode
@@ -13,6 +25,21 @@ public:
     ListenLocal = 2
   };
 
+  // How host-locked sync puts NJClient's interval on the DAW beat grid.
+  enum class AlignmentMode
+  {
+    PhaseRing = 0, // remap through the input and output interval rings
+    Direct = 1     // steer NJClient's own interval position; no rings
+  };
+
+  // Which remote channels are downloaded and decoded.
+  enum class SubscriptionPolicy
+  {
+    All = 0,
+    Unmuted = 1,
+    SoloAware = 2 // unmuted, or only soloed channels while any solo is active
+  };
+
   struct TransportState
   {
     bool isPlaying = true;
@@ -24,6 +51,10 @@ public:
     bool hostPpqValid = false;
   };
 
+  // Playback start delay after an interval wrap: <20 ms, <100 ms,
+  // <500 ms, later, and intervals that never started.
+  static constexpr int startDelayBuckets = 5;
+
   struct UserChannel
   {
     juce::String name;
@@ -31,6 +62,8 @@ public:
     float volume = 1.0f;
     bool muted = false;
     bool solo = false;
+    bool subscribed = true;
+    bool lastIntervalSilent = false;
     int channelIndex = 0;
   };
 
@@ -38,9 +71,30 @@ public:
   {
     juce::String name;
     int userIndex = 0;
+    int stemSlot = -1; // -1: mixed into the main output
+    int lateStarts = 0;
+    int dropouts = 0;
+    int silentIntervals = 0;
+    std::array<int, startDelayBuckets> startDelayHistogram {};
     std::vector<UserChannel> channels;
   };
 
+  // An additional host input bus sent as its own NJClient local channel.
+  struct LocalSend
+  {
+    juce::String name;
+    int firstChannel = 0; // index in the processBlock buffer
+    int numChannels = 2;  // 1: mono, 2: stereo pair from firstChannel
+    int bitrateKbps = 96;
+  };
+
+  struct BitrateChange
+  {
+    double sessionSeconds = 0.0;
+    int bitrateKbps = 0;
+    bool encodeOverloaded = false;
+  };
+
   struct Snapshot
   {
     bool connected = false;
@@ -62,6 +116,34 @@ public:
     float phaseOffsetMs = 0.0f;
     MonitorMode monitorMode = MonitorMode::IncomingOnly;
     bool metronomeEnabled = true;
+    AlignmentMode alignmentMode = AlignmentMode::PhaseRing;
+    bool directAlignActive = false;
+    int alignmentErrorSamples = 0;
+    int alignmentCorrections = 0;
+    float lastTimeToSyncMs = 0.0f;
+    int resyncsCompleted = 0;
+    juce::int64 ringStorageBytes = 0;
+    bool ringsCompact = false;
+    float audioBlockWorstMs = 0.0f;
+    float remoteMixWorstMs = 0.0f;
+    int remoteMixOverruns = 0;
+    int droppedEvents = 0;
+    int decodersActive = 0;
+    int activePerformers = 0;
+    int channelsSkipped = 0;
+    int bandwidthSavedKbps = 0;
+    float talkbackSendLatencyMs = 0.0f;
+    int localChannelCount = 0;
+    int encodeBacklogSamples = 0;
+    float encodeMarginMs = -1.0f; // < 0: not measured yet
+    int playPrebufferBytes = 4096;
+    int sendBitrateCapKbps = 0;
+    bool silenceGateActive = false;
+    int silentIntervalsSkipped = 0;
+    juce::int64 silentBytesSaved = 0;
+    std::vector<BitrateChange> bitrateHistory;
+    float networkDutyCycle = 0.0f;
+    float networkWakeJitterMs = 0.0f;
     juce::String syncStateText = "Classic";
     juce::StringArray logLines;
     std::vector<RemoteUser> remoteUsers;
@@ -76,16 +158,27 @@ public:
 
   void sendCommand(const juce::String& text);
   void processAudioBlock(juce::AudioBuffer<float>& buffer, const TransportState& transportState);
-  void setSampleRate(int sampleRateHz);
+  void prepare(int sampleRateHz, int maximumBlockSize, int numMainChannels, int numInputChannels);
+  void setLocalSends(const std::vector<LocalSend>& sends);
+  void setStemOutputs(const std::vector<int>& firstChannels);
+  void setTalkbackSource(int firstChannel);
+  void setAdaptiveBitrate(bool enabled, int minKbps, int maxKbps);
+  void setSilenceGate(bool enabled, float thresholdDb, float holdSeconds);
+  void setIntervalLimits(int minBpm, int maxBpi);
+  void setCompactRingStorage(bool enabled);
+  bool setMetronomeSamples(const juce::File& accentFile, const juce::File& normalFile);
 
   void setMonitorMode(MonitorMode mode);
   MonitorMode getMonitorMode() const;
   void setMetronomeEnabled(bool enabled);
   bool getMetronomeEnabled() const;
+  void setAlignmentMode(AlignmentMode mode);
+  AlignmentMode getAlignmentMode() const;
 
   void setUserChannelMute(int userIdx, int channelIdx, bool mute);
   void setUserChannelSolo(int userIdx, int channelIdx, bool solo);
   void setUserChannelVolume(int userIdx, int channelIdx, float volume);
+  void setSubscriptionPolicy(SubscriptionPolicy policy, int maxSubscriptions, const juce::StringArray& priorityUsers);
 
   void setLocalGain(float value);
   void setRemoteGain(float value);
@@ -100,10 +193,58 @@ public:
   void addLogLine(const juce::String& message);
 
 private:
+  // Typed notifications posted from the audio and network paths and
+  // formatted into log text on the message thread.
+  struct ServiceEvent
+  {
+    enum class Type : uint8_t
+    {
+      SyncModeChanged,
+      ResyncScheduled,
+      BpmChanged,
+      BpiChanged,
+      StatusChanged,
+      RingCapacityExceeded,
+      RemoteMixOverrun,
+      SubscriptionsChanged,
+      PrebufferChanged,
+      BitrateChanged,
+      SilenceGateChanged,
+      SyncAligned
+    };
+
+    Type type = Type::StatusChanged;
+    int value = 0;
+  };
+
   void timerCallback() override;
-  void ensureAllRemoteChannelsSubscribed();
+  void run() override;
+  bool runClientOnce();
+  void updateNetworkMetrics(juce::int64 wakeTicks, juce::int64 busyTicks, juce::int64 scheduledWakeTicks);
+  void updateEncodeMetrics(juce::int64 submittedBeforeRun);
+  void postEvent(ServiceEvent::Type type, int value) noexcept;
+  void drainEvents();
+  bool pollIntervalBoundary(juce::int64 nowTicks, bool& wrapped);
+  void resetSessionTracking(juce::int64 nowTicks);
+  void trackPlaybackStarts(juce::int64 nowTicks, bool wrapped);
+  void updatePrebufferController();
+  void updateBitrateController();
+  void updateSilenceGate(juce::int64 nowTicks, bool wrapped);
+  void applySendBitrateCap(int capKbps);
+  int effectiveSendBitrate(int configuredKbps) const;
+  void handleIntervalBoundary(bool wrapped);
+  void applySubscriptionPolicy(bool allowUnsubscribe);
+  void routeRemoteChannels();
+  void ensureStemRing(int slot);
+  void publishRingStorageBytes();
   void warnIfDuplicateUsername();
-  void updateMetersFromBuffer(const juce::AudioBuffer<float>& buffer);
+  void processSubBlock(juce::AudioBuffer<float>& buffer, const TransportState& transportState);
+  AudioKernels::OutputKernel selectOutputKernel(int numChannels, bool readRing, MonitorMode mode);
+  void clearStemOutputs(juce::AudioBuffer<float>& buffer, int numStems, int numSamples);
+  void publishRemoteMeter();
+  void trackBlockTime(juce::int64 blockStartTicks);
+  static void storeMaxTicks(std::atomic<juce::int64>& target, juce::int64 ticks);
+  static float measurePeak(const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples);
   void refreshStatusFromCore();
   void configureCorePaths();
 
@@ -114,45 +255,244 @@ private:
   static int licenseAgreementCallback(void* userData, const char* licenseText);
 
   static juce::String statusCodeToText(int statusCode);
+  static juce::String syncModeToText(int syncMode);
   void applySessionChannelModeToCore();
   void renderMetronome(float** outBuffers, int numChannels, int blockSize,
-                       double bpm, int bpi, double phaseBeats, int sampleRateHz);
+                       double bpm, int bpi, double phaseBeats, int sampleRateHz, float gain);
+  void rebuildMetronomeClicks(int sampleRateHz);
 
-  static void ringCopy(juce::AudioBuffer<float>& dst, int dstPos,
-                       const juce::AudioBuffer<float>& src, int srcPos,
-                       int numChannels, int numSamples, int ringLen);
   static float clampMeter(float value);
+  void resetSyncStateForAudioThread();
 
+  // `lock` guards `state` for the message thread and NJClient callbacks.
+  // The audio thread never takes it: everything it needs is exchanged
+  // through the atomics below.
   mutable juce::CriticalSection lock;
   Snapshot state;
   NJClient client;
-  int sampleRate = 48000;
+
+  // Serialises NJClient API calls between the network thread (Run) and the
+  // message thread. Lock order: clientLock before lock, never the reverse.
+  juce::CriticalSection clientLock;
+  // Signalled from the message thread only: WaitableEvent::signal takes a
+  // mutex. The audio thread raises encodeWakePending instead, which the
+  // network thread checks before each poll wait.
+  juce::WaitableEvent networkWakeEvent;
+  std::atomic<bool> encodeWakePending { false };
+  int pendingEncodeSamples = 0;
+  std::atomic<juce::int64> submittedEncodeSamples { 0 };
+
+  // Network-thread-only metrics, published by refreshStatusFromCore.
+  juce::int64 networkWindowStartTicks = 0;
+  juce::int64 networkWindowBusyTicks = 0;
+  juce::int64 networkWindowMaxJitterTicks = 0;
+  float networkDutyCycle = 0.0f;
+  float networkWakeJitterMs = 0.0f;
+  int lastReportedAudioProcOverruns = 0;
+  int lastBoundaryIntervalPos = 0;
+  juce::int64 lastIntervalAdvanceTicks = 0;
+  bool unsubscribePending = false;
+  int subscribedChannelCount = 0;
+  int skippedChannelCount = 0;
+
+  // Adaptive prebuffer. NJClient does not report how much of a peer's
+  // interval has downloaded, so arrival problems are read from playback: a
+  // channel that played into the wrap but is still exact digital silence
+  // well after it started late, and one that falls silent for a moment
+  // mid-interval dropped out.
+  struct PeerJitterStats
+  {
+    int lateStarts = 0;
+    int dropouts = 0;
+    int silentIntervals = 0;
+    std::array<int, startDelayBuckets> histogram {};
+  };
+
+  struct ChannelPlaybackState
+  {
+    bool audible = false;
+    bool awaitingStart = false;
+    float intervalPeak = 0.0f;
+    bool lastIntervalSilent = false;
+    juce::int64 lastAudibleTicks = 0;
+    juce::int64 gapStartTicks = 0; // 0: not in a gap
+  };
+
+  std::map<juce::String, PeerJitterStats> peerJitterStats;
+  std::map<juce::String, ChannelPlaybackState> channelPlayback;
+  bool networkSessionConnected = false;
+  juce::int64 lastIntervalWrapTicks = 0;
+  int playPrebufferBytes = 4096;
+  int jitterWindowStarts = 0;
+  int jitterWindowLateStarts = 0;
+  int jitterWindowDropouts = 0;
+  int activePerformerCount = 0;
+
+  // Encode-load bitrate adaptation (opt-in): a cap over every interval-mode
+  // local channel, stepped once per interval from the encode backlog and
+  // margin. Guarded by clientLock, like the NJClient channel setup it drives.
+  bool adaptiveBitrateEnabled = false;
+  int adaptiveBitrateMinKbps = 32;
+  int adaptiveBitrateMaxKbps = 256;
+  int sendBitrateCapKbps = 0; // 0: not yet limited
+  int healthyBitrateIntervals = 0;
+  int encodeBacklogIntervalPeak = 0;
+  std::map<int, int> configuredSendBitrates;
+  std::vector<BitrateChange> bitrateHistory;
+  juce::int64 sessionStartTicks = 0;
+
+  // Sender-side silence gate. The audio thread stamps the last block whose
+  // input crossed the threshold; after the hold time the network thread
+  // stops broadcasting the interval-mode channels. NJClient samples the
+  // broadcast flag per interval, so a gated interval is simply never
+  // uploaded and peers play silence for it. Gate state is guarded by
+  // clientLock.
+  std::atomic<bool> silenceGateEnabledParam { false };
+  std::atomic<float> silenceThresholdParam { 0.001f };
+  std::atomic<float> silenceHoldSecondsParam { 8.0f };
+  std::atomic<juce::int64> lastAudibleInputTicks { 0 };
+  bool silenceGated = false;
+  bool silenceGatedAtIntervalStart = false;
+  int silentIntervalsSkipped = 0;
+  juce::int64 silentBytesSaved = 0;
+  juce::int64 encodedSamples = 0;
+  int encodeBacklogPeak = 0;
+  int encodeBacklogSamples = 0;
+  int lastEncodeIntervalPos = 0;
+  float encodeMarginMs = -1.0f; // < 0: no interval encoded yet this session
+  std::atomic<int> sampleRate { 48000 };
   int lastStatusCode = NJClient::NJC_STATUS_DISCONNECTED;
-  double lastHostPpq = 0.0;
-  bool lastHostPpqValid = false;
-  double lastHostBpm = 0.0;
-  bool lastHostBpmValid = false;
-  bool hostLockedActive = false;
+
+  // Parameters (message thread → audio thread)
+  std::atomic<float> localGainParam { 1.0f };
+  std::atomic<float> remoteGainParam { 1.0f };
+  std::atomic<float> phaseOffsetMsParam { 0.0f };
+  std::atomic<int> monitorModeParam { static_cast<int>(MonitorMode::IncomingOnly) };
+  std::atomic<bool> metronomeEnabledParam { true };
+  std::atomic<int> alignmentModeParam { static_cast<int>(AlignmentMode::PhaseRing) };
+  std::atomic<int> roomBpiParam { 16 };
+  std::atomic<int> sessionBpmParam { 120 };
+  std::atomic<bool> forceSeekPending { false };
+  std::atomic<bool> syncResetPending { false };
+  std::atomic<int> subscriptionPolicyParam { static_cast<int>(SubscriptionPolicy::All) };
+  std::atomic<int> maxSubscriptionsParam { 0 };
+  std::atomic<bool> subscriptionDirty { true };
+  juce::StringArray subscriptionPriority; // guarded by lock
+
+  // Host clock and sync state (audio thread → message thread)
+  std::atomic<double> lastHostPpq { 0.0 };
+  std::atomic<bool> lastHostPpqValid { false };
+  std::atomic<double> lastHostBpm { 0.0 };
+  std::atomic<bool> lastHostBpmValid { false };
+  std::atomic<bool> hostLockedActive { false };
+  std::atomic<int> publishedSyncMode { -1 };
+  std::atomic<bool> directAlignActive { false };
+  std::atomic<int> alignmentErrorSamples { 0 };
+  std::atomic<int> alignmentCorrections { 0 };
+  std::atomic<float> lastTimeToSyncMs { 0.0f };
+  std::atomic<int> resyncsCompleted { 0 };
+  std::atomic<juce::int64> worstBlockTicks { 0 };
+  std::atomic<juce::int64> worstAudioProcTicks { 0 };
+  std::atomic<int> audioProcOverruns { 0 };
+  RealtimeEventQueue<ServiceEvent, 256> eventQueue;
+
+  MeterSlot sendMeterSlot;
+  MeterSlot localMeterSlot;
+  MeterSlot remoteMeterSlot;
+  uint32_t lastSendMeterSequence = 0;
+  uint32_t lastLocalMeterSequence = 0;
+  uint32_t lastRemoteMeterSequence = 0;
+
+  // Audio-thread-only state
   int lastSyncMode = -1;
+  int maxSubBlockSamples = 1024; // set in prepare()
+  bool lastDirectAligned = false;
+  int directStallSamples = 0;   // NJClient hold still owed by direct alignment
+  int directAdvanceSamples = 0; // silent run-ahead still owed by direct alignment
+  float remoteMeterSmoothed = 0.0f;
+  int outputKernelKey = -1;
+  AudioKernels::OutputKernel outputKernel = nullptr;
+
   bool duplicateNameWarned = false;
-  bool forceSeekPending = false;
   int lastServerBpm = 0;
   int lastServerBpi = 0;
-  bool hostPhaseAccumulatorValid = false;
-  double hostPhaseAccumulatorBeats = 0.0;
-  double lastHostPhaseBeat = 0.0;
+  // Host-locked sync clock: session position and the DAW phase anchor.
+  SampleClock::HostClock hostClock;
+
+  // Host bus geometry from prepare(). Channels past the main bus belong to
+  // the additional send buses and are passed to AudioProc in place.
+  int hostMainChannels = 2;
+  int hostInputChannels = 2;
+  int activeLocalSends = 0;
+
+  // Optional low-latency talkback: a voice-chat-mode local channel fed
+  // from a host channel outside the input ring. The audio thread stamps
+  // the oldest block not yet handed to Run(); the network thread turns
+  // that into the capture-to-upload latency.
+  int talkbackSourceChannel = -1;
+  bool talkbackActive = false;
+  std::atomic<juce::int64> talkbackOldestUnsentTicks { 0 };
+  float talkbackSendLatencyPeakMs = 0.0f;
+
+  // Per-user stem outputs. NJClient renders each routed user into output
+  // channels 2 + 2 * slot; the audio thread copies them to the host bus
+  // starting at stemFirstChannels[slot]. Slots are keyed by username on the
+  // network thread so a user who drops and rejoins keeps the same bus.
+  static constexpr int maxStemOutputs = 8;
+  int stemFirstChannels[maxStemOutputs] = {};
+  int numStemOutputs = 0;
+  std::atomic<int> stemSlotCount { 0 };
+  std::atomic<bool> stemRoutingDirty { false };
+  std::atomic<bool> voiceOutputAvailable { true };
+  juce::StringArray stemSlotUsers;
 
   juce::AudioBuffer<float> inputScratch;
-  juce::AudioBuffer<float> txMonitorScratch;
   juce::AudioBuffer<float> outputScratch;
 
-  juce::AudioBuffer<float> phaseRingBuffer;
-  int phaseRingIntervalLen = 0;
+  // Interval rings are allocated in prepare() for the longest interval the
+  // configured BPM/BPI limits allow; an interval change only moves the
+  // logical length, so the audio thread never reallocates them.
+  int ringLimitMinBpm = 60;
+  int ringLimitMaxBpi = 32;
+  bool ringCompactStorage = false;
+  int ringCapacity = 0;
+  int lastRingCapacityWarningLen = 0;
+  std::atomic<juce::int64> ringStorageBytes { 0 };
+  std::atomic<bool> ringsCompactPublished { false }; // phaseRingBuffer.isCompact() for getSnapshot
+
+  IntervalRing phaseRingBuffer; // main bus only
+  juce::AudioBuffer<float> phaseRingReadScratch; // compact rings only
+
+  // One phase ring per stem slot, allocated only once a user is routed to
+  // the slot, so enabled but unused stem buses cost no ring memory. The
+  // network thread allocates under clientLock and publishes through
+  // stemRingReady; after that only the audio thread touches the ring until
+  // the next prepare().
+  IntervalRing stemRings[maxStemOutputs];
+  std::atomic<bool> stemRingReady[maxStemOutputs] = {};
+  juce::AudioBuffer<float> stemRingReadScratch; // compact rings only
+
+  IntervalRing inputRingBuffer;
+
+  // Samples since a resync (connect, tempo change, seek, mode switch) began,
+  // or -1 once output is back on the DAW grid.
+  juce::int64 resyncElapsedSamples = -1;
+  // Click waveforms rendered once per sample rate (built-in tones or
+  // user-supplied samples). Swapped under a spin lock the audio thread
+  // only ever try-locks.
+  struct MetronomeClickCache
+  {
+    int sampleRateHz = 0;
+    std::vector<float> accent;
+    std::vector<float> normal;
+  };
 
-  juce::AudioBuffer<float> inputRingBuffer;
-  int inputRingIntervalLen = 0;
-  double phaseRingBeatOffset = 0.0;
-  bool phaseRingOffsetValid = false;
-  int metronomeClickState = 0;
+  std::unique_ptr<MetronomeClickCache> metronomeClicks;
+  juce::SpinLock metronomeClicksLock;
+  juce::AudioBuffer<float> customAccentClick;
+  juce::AudioBuffer<float> customNormalClick;
+  double customAccentClickRate = 0.0;
+  double customNormalClickRate = 0.0;
+  int metronomeClickPos = -1;
   bool metronomeClickAccent = false;
 };
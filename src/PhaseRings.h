@@ -0,0 +1,90 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "IntervalRing.h"
+
+#include <cmath>
+
+// The ring stages of host-locked sync for NinjamClientService::processSubBlock.
+// Server interval position 0 is DAW beat 0 in both directions: the input
+// ring puts sender audio into server order before NJClient encodes it, and
+// the phase ring puts NJClient's output back on the receiver's beat grid.
+// Once the rings and scratch buffers are prepared, nothing here allocates.
+namespace PhaseRings
+{
+// Ring position of a DAW phase in beats, for an interval of bpi beats
+// lasting intervalLen samples.
+inline int beatToPosition(double dawPhase, int bpi, int intervalLen) noexcept
+{
+  const double bpiD = static_cast<double>(bpi);
+  double dawBeat = std::fmod(dawPhase, bpiD);
+  if (dawBeat < 0.0)
+    dawBeat += bpiD;
+  return static_cast<int>(dawBeat / bpiD * static_cast<double>(intervalLen));
+}
+
+// Input ring: writes the host block at its DAW position and reads the
+// block at NJClient's server position into scratch. Positions the DAW has
+// not reached since the last resync are sent as silence.
+inline void remapInput(IntervalRing& ring, juce::AudioBuffer<float>& scratch, const juce::AudioBuffer<float>& host,
+                       int numChannels, int numSamples, int writePos, int serverPos, int intervalLen) noexcept
+{
+  if (intervalLen != ring.getLength())
+    ring.setLength(intervalLen);
+
+  ring.writeFrom(host, 0, numSamples, writePos, numChannels, numSamples);
+  ring.markWritten(writePos, numSamples);
+  ring.clearUnwritten(serverPos, numSamples, numChannels);
+  ring.readInto(scratch, 0, numSamples, serverPos, numChannels, numSamples);
+}
+
+// Phase ring, write side: stores the block NJClient just rendered, which
+// ended at serverPosAfter. Returns true when the interval length changed,
+// which restarts the ring empty.
+inline bool writeOutput(IntervalRing& ring, const juce::AudioBuffer<float>& output,
+                        int numChannels, int numSamples, int serverPosAfter, int intervalLen) noexcept
+{
+  const bool lengthChanged = intervalLen != ring.getLength();
+  if (lengthChanged)
+    ring.setLength(intervalLen);
+
+  // A block straddling the first boundary of a new geometry only keeps its
+  // new-interval part.
+  const bool seedAtBoundary = ring.getFilledSamples() == 0 && serverPosAfter > 0 && serverPosAfter <= numSamples;
+  const int writeLen = seedAtBoundary ? serverPosAfter : numSamples;
+  ring.writeFrom(output, numSamples - writeLen, numSamples, serverPosAfter - writeLen, numChannels, writeLen);
+  ring.markWritten(serverPosAfter - writeLen, writeLen);
+  return lengthChanged;
+}
+
+// Where the output kernels read a block from: channel pointers wrapping
+// at len, starting at pos.
+struct RingRead
+{
+  int pos = 0;
+  int len = 0;
+};
+
+// Phase ring, read side: silences the part of the block NJClient has not
+// written since the last resync, then points channels at it. Float rings
+// are read in place; compact rings unpack the block into scratch first.
+inline RingRead readOutput(IntervalRing& ring, juce::AudioBuffer<float>& unpackScratch, const float** channels,
+                           int numChannels, int numSamples, int readPos) noexcept
+{
+  const int len = ring.getLength();
+  readPos = ((readPos % len) + len) % len;
+  ring.clearUnwritten(readPos, numSamples, numChannels);
+
+  if (ring.isCompact())
+  {
+    ring.readInto(unpackScratch, 0, numSamples, readPos, numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+      channels[ch] = unpackScratch.getReadPointer(ch);
+    return { 0, numSamples };
+  }
+
+  for (int ch = 0; ch < numChannels; ++ch)
+    channels[ch] = ring.getFloatPointer(ch);
+  return { readPos, len };
+}
+}
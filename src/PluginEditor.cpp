@@ -6,6 +6,7 @@ namespace
 {
 constexpr int kPadding = 10;
 constexpr int kRowHeight = 24;
+constexpr int kDiagnosticsRowHeight = 16;
 constexpr int kStripHeight = 32;
 constexpr int kVuBarWidth = 140;
 constexpr int kButtonWidth = 28;
@@ -30,6 +31,21 @@ juce::String formatOffsetText(float value)
     return juce::String(static_cast<int>(std::round(rounded)));
   return juce::String(rounded, 1);
 }
+
+juce::String formatUserLabel(const NinjamClientService::RemoteUser& user)
+{
+  auto label = user.name;
+  if (user.stemSlot >= 0)
+    label += " [Stem " + juce::String(user.stemSlot + 1) + "]";
+  juce::StringArray arrival;
+  if (user.lateStarts > 0)
+    arrival.add("late " + juce::String(user.lateStarts));
+  if (user.dropouts > 0)
+    arrival.add("dropouts " + juce::String(user.dropouts));
+  if (arrival.size() > 0)
+    label += " (" + arrival.joinIntoString(", ") + ")";
+  return label;
+}
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -139,7 +155,7 @@ UserStripComponent::UserStripComponent(NinjamNextAudioProcessor& proc,
                                        const NinjamClientService::RemoteUser& user)
   : processor(proc), userIdx(user.userIndex), userName(user.name)
 {
-  nameLabel.setText(userName, juce::dontSendNotification);
+  nameLabel.setText(formatUserLabel(user), juce::dontSendNotification);
   nameLabel.setFont(juce::FontOptions(13.0f, juce::Font::bold));
   nameLabel.setColour(juce::Label::textColourId, juce::Colours::white);
   addAndMakeVisible(nameLabel);
@@ -194,7 +210,7 @@ void UserStripComponent::update(const NinjamClientService::RemoteUser& user)
 {
   userIdx = user.userIndex;
   userName = user.name;
-  nameLabel.setText(userName, juce::dontSendNotification);
+  nameLabel.setText(formatUserLabel(user), juce::dontSendNotification);
 
   if (static_cast<int>(user.channels.size()) != channelStrips.size())
   {
@@ -464,6 +480,11 @@ NinjamNextAudioProcessorEditor::NinjamNextAudioProcessorEditor(NinjamNextAudioPr
   metronomeToggle.onClick = [this] { metronomeChanged(); };
   addAndMakeVisible(metronomeToggle);
 
+  directAlignToggle.setButtonText("Direct");
+  directAlignToggle.setTooltip("Lock the NINJAM interval to DAW beats without the phase rings (lower latency)");
+  directAlignToggle.onClick = [this] { alignmentModeChanged(); };
+  addAndMakeVisible(directAlignToggle);
+
   phaseOffsetLabel.setText("Offset", juce::dontSendNotification);
   addAndMakeVisible(phaseOffsetLabel);
   phaseOffsetEditor.setInputRestrictions(8, "-0123456789.");
@@ -472,6 +493,15 @@ NinjamNextAudioProcessorEditor::NinjamNextAudioProcessorEditor(NinjamNextAudioPr
   phaseOffsetEditor.onFocusLost = [this] { phaseOffsetEdited(); };
   addAndMakeVisible(phaseOffsetEditor);
 
+  for (auto* label : { &audioDiagnosticsLabel, &syncDiagnosticsLabel, &networkDiagnosticsLabel,
+                        &sendDiagnosticsLabel, &remoteDiagnosticsLabel })
+  {
+    label->setFont(juce::FontOptions(12.0f));
+    label->setMinimumHorizontalScale(1.0f);
+    label->setColour(juce::Label::textColourId, juce::Colours::grey);
+    addAndMakeVisible(*label);
+  }
+
   mixerViewport.setViewedComponent(&mixerContent, false);
   mixerViewport.setScrollBarsShown(true, false);
   addAndMakeVisible(mixerViewport);
@@ -500,6 +530,8 @@ NinjamNextAudioProcessorEditor::NinjamNextAudioProcessorEditor(NinjamNextAudioPr
 
   ignoreToggleCallback = true;
   metronomeToggle.setToggleState(snapshot.metronomeEnabled, juce::dontSendNotification);
+  directAlignToggle.setToggleState(snapshot.alignmentMode == NinjamClientService::AlignmentMode::Direct,
+                                   juce::dontSendNotification);
   ignoreToggleCallback = false;
 
   refreshFromService();
@@ -550,16 +582,26 @@ void NinjamNextAudioProcessorEditor::resized()
 
   area.removeFromTop(6);
 
-  // Info row: BPM + BPI + Interval + Metronome + Offset
+  // Info row: BPM + BPI + Interval + Metronome + Direct + Offset
   auto row3 = area.removeFromTop(kRowHeight);
   bpmLabel.setBounds(row3.removeFromLeft(300));
   bpiLabel.setBounds(row3.removeFromLeft(90));
   intervalLabel.setBounds(row3.removeFromLeft(160));
   metronomeToggle.setBounds(row3.removeFromLeft(110));
+  directAlignToggle.setBounds(row3.removeFromLeft(80));
   row3.removeFromLeft(8);
   phaseOffsetLabel.setBounds(row3.removeFromLeft(46));
   phaseOffsetEditor.setBounds(row3.removeFromLeft(70));
 
+  area.removeFromTop(4);
+
+  // Diagnostics rows: audio engine, sync, network, send path, remote users
+  audioDiagnosticsLabel.setBounds(area.removeFromTop(kDiagnosticsRowHeight));
+  syncDiagnosticsLabel.setBounds(area.removeFromTop(kDiagnosticsRowHeight));
+  networkDiagnosticsLabel.setBounds(area.removeFromTop(kDiagnosticsRowHeight));
+  sendDiagnosticsLabel.setBounds(area.removeFromTop(kDiagnosticsRowHeight));
+  remoteDiagnosticsLabel.setBounds(area.removeFromTop(kDiagnosticsRowHeight));
+
   area.removeFromTop(8);
 
   // Mixer panel (takes a portion of remaining space)
@@ -617,6 +659,14 @@ void NinjamNextAudioProcessorEditor::refreshFromService()
     ignoreToggleCallback = false;
   }
 
+  const bool directAlign = snapshot.alignmentMode == NinjamClientService::AlignmentMode::Direct;
+  if (directAlignToggle.getToggleState() != directAlign)
+  {
+    ignoreToggleCallback = true;
+    directAlignToggle.setToggleState(directAlign, juce::dontSendNotification);
+    ignoreToggleCallback = false;
+  }
+
   if (!phaseOffsetEditor.hasKeyboardFocus(true))
   {
     const auto offsetText = formatOffsetText(snapshot.phaseOffsetMs);
@@ -624,6 +674,68 @@ void NinjamNextAudioProcessorEditor::refreshFromService()
       phaseOffsetEditor.setText(offsetText, juce::dontSendNotification);
   }
 
+  juce::StringArray audioDiagnostics;
+  audioDiagnostics.add("Audio worst block: " + juce::String(snapshot.audioBlockWorstMs, 2) + " ms"
+                       + " (mix " + juce::String(snapshot.remoteMixWorstMs, 2) + " ms, "
+                       + juce::String(snapshot.remoteMixOverruns) + " overruns)");
+  if (snapshot.ringStorageBytes > 0)
+    audioDiagnostics.add("Rings: " + juce::String(static_cast<double>(snapshot.ringStorageBytes) / (1024.0 * 1024.0), 1) + " MB"
+                         + (snapshot.ringsCompact ? " (16-bit)" : ""));
+
+  juce::StringArray syncDiagnostics;
+  if (snapshot.resyncsCompleted > 0)
+    syncDiagnostics.add("Time to sync: " + juce::String(snapshot.lastTimeToSyncMs, 1) + " ms");
+  if (snapshot.directAlignActive)
+    syncDiagnostics.add("Align error: " + juce::String(snapshot.alignmentErrorSamples) + " smp ("
+                        + juce::String(snapshot.alignmentCorrections) + " corrections)");
+  if (snapshot.droppedEvents > 0)
+    syncDiagnostics.add("Dropped events: " + juce::String(snapshot.droppedEvents));
+
+  juce::StringArray networkDiagnostics;
+  networkDiagnostics.add("Net duty: " + juce::String(snapshot.networkDutyCycle * 100.0f, 1) + "%");
+  networkDiagnostics.add("Net jitter: " + juce::String(snapshot.networkWakeJitterMs, 1) + " ms");
+  if (snapshot.connected)
+  {
+    networkDiagnostics.add("Prebuffer: " + juce::String(snapshot.playPrebufferBytes) + " B");
+    if (snapshot.sendBitrateCapKbps > 0)
+      networkDiagnostics.add("Encode-load cap: " + juce::String(snapshot.sendBitrateCapKbps) + " kbps");
+  }
+
+  juce::StringArray sendDiagnostics;
+  if (snapshot.localChannelCount > 0)
+  {
+    auto encoder = "Encoder (" + juce::String(snapshot.localChannelCount) + " ch): "
+                 + juce::String(snapshot.encodeBacklogSamples) + " smp backlog";
+    if (snapshot.encodeMarginMs >= 0.0f)
+      encoder += ", " + juce::String(snapshot.encodeMarginMs / 1000.0f, 1) + " s margin";
+    sendDiagnostics.add(encoder);
+  }
+  if (snapshot.talkbackSendLatencyMs > 0.0f)
+    sendDiagnostics.add("Talkback send: " + juce::String(snapshot.talkbackSendLatencyMs, 1) + " ms");
+  if (snapshot.silenceGateActive || snapshot.silentIntervalsSkipped > 0)
+  {
+    sendDiagnostics.add("Silent intervals: " + juce::String(snapshot.silentIntervalsSkipped)
+                        + " (" + juce::String(snapshot.silentBytesSaved / 1024) + " KB saved)");
+  }
+
+  juce::StringArray remoteDiagnostics;
+  if (snapshot.connected)
+  {
+    juce::String decoders = "Decoders: " + juce::String(snapshot.decodersActive);
+    if (snapshot.channelsSkipped > 0)
+      decoders += " (" + juce::String(snapshot.channelsSkipped) + " skipped, ~"
+                + juce::String(snapshot.bandwidthSavedKbps) + " kbps saved)";
+    remoteDiagnostics.add(decoders);
+    remoteDiagnostics.add("Active: " + juce::String(snapshot.activePerformers) + "/"
+                          + juce::String(static_cast<int>(snapshot.remoteUsers.size())));
+  }
+
+  audioDiagnosticsLabel.setText(audioDiagnostics.joinIntoString(" | "), juce::dontSendNotification);
+  syncDiagnosticsLabel.setText(syncDiagnostics.joinIntoString(" | "), juce::dontSendNotification);
+  networkDiagnosticsLabel.setText(networkDiagnostics.joinIntoString(" | "), juce::dontSendNotification);
+  sendDiagnosticsLabel.setText(sendDiagnostics.joinIntoString(" | "), juce::dontSendNotification);
+  remoteDiagnosticsLabel.setText(remoteDiagnostics.joinIntoString(" | "), juce::dontSendNotification);
+
   // Update mixer panel
   mixerContent.updateFromSnapshot(snapshot);
 
@@ -671,3 +783,13 @@ void NinjamNextAudioProcessorEditor::metronomeChanged()
 
   processor.setMetronomeEnabled(metronomeToggle.getToggleState());
 }
+
+void NinjamNextAudioProcessorEditor::alignmentModeChanged()
+{
+  if (ignoreToggleCallback)
+    return;
+
+  processor.setAlignmentMode(directAlignToggle.getToggleState()
+                               ? NinjamClientService::AlignmentMode::Direct
+                               : NinjamClientService::AlignmentMode::PhaseRing);
+}
@@ -123,6 +123,7 @@ private:
   void sendCommandPressed();
   void phaseOffsetEdited();
   void metronomeChanged();
+  void alignmentModeChanged();
 
   NinjamNextAudioProcessor& processor;
 
@@ -146,10 +147,17 @@ private:
   juce::Label intervalLabel;
 
   juce::ToggleButton metronomeToggle;
+  juce::ToggleButton directAlignToggle;
 
   juce::Label phaseOffsetLabel;
   juce::TextEditor phaseOffsetEditor;
 
+  juce::Label audioDiagnosticsLabel;
+  juce::Label syncDiagnosticsLabel;
+  juce::Label networkDiagnosticsLabel;
+  juce::Label sendDiagnosticsLabel;
+  juce::Label remoteDiagnosticsLabel;
+
   juce::Viewport mixerViewport;
   MixerContentComponent mixerContent;
 
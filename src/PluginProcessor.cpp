@@ -5,6 +5,28 @@
 
 namespace
 {
+constexpr int kNumSendBuses = 3;
+constexpr int kNumStemBuses = 8;
+constexpr int kDefaultSendBitrateKbps = 96;
+
+juce::AudioProcessor::BusesProperties makeBusesProperties()
+{
+  auto buses = juce::AudioProcessor::BusesProperties()
+                 .withInput("Input", juce::AudioChannelSet::stereo(), true)
+                 .withOutput("Output", juce::AudioChannelSet::stereo(), true);
+
+  // Extra sources (vocal, talkback, ...) share this instance's connection
+  // as separate NJClient local channels; hosts enable them on demand.
+  for (int i = 0; i < kNumSendBuses; ++i)
+    buses = buses.withInput("Send " + juce::String(i + 2), juce::AudioChannelSet::stereo(), false);
+
+  // One stereo stem per remote user, assigned by username.
+  for (int i = 0; i < kNumStemBuses; ++i)
+    buses = buses.withOutput("Stem " + juce::String(i + 1), juce::AudioChannelSet::stereo(), false);
+
+  return buses;
+}
+
 NinjamClientService::MonitorMode monitorModeFromInt(int value)
 {
   switch (value)
@@ -23,11 +45,16 @@ NinjamClientService::MonitorMode monitorModeFromLegacyFlags(bool monitorIncoming
     return NinjamClientService::MonitorMode::AddLocal;
   return NinjamClientService::MonitorMode::IncomingOnly;
 }
+
+NinjamClientService::AlignmentMode alignmentModeFromInt(int value)
+{
+  return value == 1 ? NinjamClientService::AlignmentMode::Direct
+                    : NinjamClientService::AlignmentMode::PhaseRing;
+}
 }
 
 NinjamNextAudioProcessor::NinjamNextAudioProcessor()
-  : AudioProcessor(BusesProperties().withInput("Input", juce::AudioChannelSet::stereo(), true)
-                                    .withOutput("Output", juce::AudioChannelSet::stereo(), true))
+  : AudioProcessor(makeBusesProperties())
 {
   initialiseSettings();
   loadCredentialsFromSettings();
@@ -41,13 +68,16 @@ NinjamNextAudioProcessor::~NinjamNextAudioProcessor()
 
 void NinjamNextAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-  juce::ignoreUnused(samplesPerBlock);
   sampleRateHz = sampleRate > 1.0 ? sampleRate : 48000.0;
   lastHostTimeSeconds = -1.0;
   lastHostPpq = 0.0;
   lastHostPpqValid = false;
   lastHostWasPlaying = false;
-  clientService.setSampleRate(juce::roundToInt(sampleRate));
+  clientService.setLocalSends(buildLocalSends());
+  clientService.setStemOutputs(buildStemOutputs());
+  clientService.setTalkbackSource(findTalkbackChannel());
+  clientService.prepare(juce::roundToInt(sampleRateHz), samplesPerBlock,
+                        getMainBusNumInputChannels(), getTotalNumInputChannels());
 
   if (!autoConnectAttempted)
   {
@@ -73,7 +103,85 @@ bool NinjamNextAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts
 {
   const auto input = layouts.getMainInputChannelSet();
   const auto output = layouts.getMainOutputChannelSet();
-  return input == output && (output == juce::AudioChannelSet::stereo() || output == juce::AudioChannelSet::mono());
+  if (input != output || (output != juce::AudioChannelSet::stereo() && output != juce::AudioChannelSet::mono()))
+    return false;
+
+  for (int bus = 1; bus < layouts.inputBuses.size(); ++bus)
+  {
+    const auto send = layouts.getChannelSet(true, bus);
+    if (!send.isDisabled() && send != juce::AudioChannelSet::stereo() && send != juce::AudioChannelSet::mono())
+      return false;
+  }
+
+  // Stems are stereo and need a stereo main bus.
+  for (int bus = 1; bus < layouts.outputBuses.size(); ++bus)
+  {
+    const auto stem = layouts.getChannelSet(false, bus);
+    if (stem.isDisabled())
+      continue;
+    if (stem != juce::AudioChannelSet::stereo() || output != juce::AudioChannelSet::stereo())
+      return false;
+  }
+
+  return true;
+}
+
+int NinjamNextAudioProcessor::getTalkbackBusIndex()
+{
+  // "talkbackBus" names a send bus by its number ("Send 3" -> 3); 0 is off.
+  auto* settings = appProperties.getUserSettings();
+  const int busNumber = settings != nullptr ? settings->getIntValue("talkbackBus", 0) : 0;
+  return busNumber >= 2 ? busNumber - 1 : -1;
+}
+
+int NinjamNextAudioProcessor::findTalkbackChannel()
+{
+  const int busIdx = getTalkbackBusIndex();
+  if (busIdx < 1 || busIdx >= getBusCount(true))
+    return -1;
+
+  const auto* bus = getBus(true, busIdx);
+  if (bus == nullptr || !bus->isEnabled() || bus->getNumberOfChannels() == 0)
+    return -1;
+
+  return getChannelIndexInProcessBlockBuffer(true, busIdx, 0);
+}
+
+std::vector<int> NinjamNextAudioProcessor::buildStemOutputs() const
+{
+  std::vector<int> firstChannels;
+  for (int busIdx = 1; busIdx < getBusCount(false); ++busIdx)
+  {
+    const auto* bus = getBus(false, busIdx);
+    if (bus != nullptr && bus->isEnabled() && bus->getNumberOfChannels() == 2)
+      firstChannels.push_back(getChannelIndexInProcessBlockBuffer(false, busIdx, 0));
+  }
+  return firstChannels;
+}
+
+std::vector<NinjamClientService::LocalSend> NinjamNextAudioProcessor::buildLocalSends()
+{
+  std::vector<NinjamClientService::LocalSend> sends;
+  auto* settings = appProperties.getUserSettings();
+  const int talkbackBusIdx = getTalkbackBusIndex();
+
+  for (int busIdx = 1; busIdx < getBusCount(true); ++busIdx)
+  {
+    const auto* bus = getBus(true, busIdx);
+    if (busIdx == talkbackBusIdx || bus == nullptr || !bus->isEnabled() || bus->getNumberOfChannels() == 0)
+      continue;
+
+    NinjamClientService::LocalSend send;
+    send.name = bus->getName();
+    send.firstChannel = getChannelIndexInProcessBlockBuffer(true, busIdx, 0);
+    send.numChannels = bus->getNumberOfChannels();
+    send.bitrateKbps = settings != nullptr
+                     ? settings->getIntValue("sendBitrate" + juce::String(busIdx + 1), kDefaultSendBitrateKbps)
+                     : kDefaultSendBitrateKbps;
+    sends.push_back(send);
+  }
+
+  return sends;
 }
 
 void NinjamNextAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
@@ -248,6 +356,7 @@ void NinjamNextAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
   state.setProperty("password", snapshot.password, nullptr);
   state.setProperty("monitorMode", static_cast<int>(clientService.getMonitorMode()), nullptr);
   state.setProperty("metronomeEnabled", clientService.getMetronomeEnabled(), nullptr);
+  state.setProperty("alignmentMode", static_cast<int>(clientService.getAlignmentMode()), nullptr);
 
   if (auto xml = state.createXml())
   {
@@ -292,6 +401,8 @@ void NinjamNextAudioProcessor::setStateInformation(const void* data, int sizeInB
 
   clientService.setMetronomeEnabled(static_cast<bool>(
     state.getProperty("metronomeEnabled", clientService.getMetronomeEnabled())));
+  clientService.setAlignmentMode(alignmentModeFromInt(static_cast<int>(
+    state.getProperty("alignmentMode", static_cast<int>(clientService.getAlignmentMode())))));
 
   if (host.isNotEmpty() && user.isNotEmpty())
   {
@@ -340,6 +451,17 @@ bool NinjamNextAudioProcessor::getMetronomeEnabled() const
   return clientService.getMetronomeEnabled();
 }
 
+void NinjamNextAudioProcessor::setAlignmentMode(NinjamClientService::AlignmentMode mode)
+{
+  clientService.setAlignmentMode(mode);
+  saveAlignmentModeSetting(mode);
+}
+
+NinjamClientService::AlignmentMode NinjamNextAudioProcessor::getAlignmentMode() const
+{
+  return clientService.getAlignmentMode();
+}
+
 void NinjamNextAudioProcessor::setUserChannelMute(int userIdx, int channelIdx, bool mute)
 {
   clientService.setUserChannelMute(userIdx, channelIdx, mute);
@@ -393,6 +515,33 @@ void NinjamNextAudioProcessor::loadCredentialsFromSettings()
     }
 
     clientService.setMetronomeEnabled(settings->getBoolValue("metronomeEnabled", true));
+    clientService.setAlignmentMode(alignmentModeFromInt(settings->getIntValue("alignmentMode", 0)));
+    clientService.setIntervalLimits(settings->getIntValue("ringMinBpm", 60),
+                                    settings->getIntValue("ringMaxBpi", 32));
+    clientService.setCompactRingStorage(settings->getBoolValue("ringCompactStorage", false));
+
+    clientService.setAdaptiveBitrate(settings->getBoolValue("adaptiveBitrate", false),
+                                     settings->getIntValue("sendBitrateMin", 32),
+                                     settings->getIntValue("sendBitrateMax", 256));
+
+    clientService.setSilenceGate(settings->getBoolValue("silenceGate", false),
+                                 static_cast<float>(settings->getDoubleValue("silenceThresholdDb", -60.0)),
+                                 static_cast<float>(settings->getDoubleValue("silenceHoldSeconds", 8.0)));
+
+    auto priorityUsers = juce::StringArray::fromTokens(settings->getValue("subscriptionPriority"), ",", {});
+    priorityUsers.trim();
+    priorityUsers.removeEmptyStrings();
+    const auto policy = juce::jlimit(0, 2, settings->getIntValue("subscriptionPolicy", 0));
+    clientService.setSubscriptionPolicy(static_cast<NinjamClientService::SubscriptionPolicy>(policy),
+                                        settings->getIntValue("maxSubscriptions", 0), priorityUsers);
+
+    const auto accentSample = settings->getValue("metronomeAccentSample");
+    const auto normalSample = settings->getValue("metronomeNormalSample");
+    if (accentSample.isNotEmpty() || normalSample.isNotEmpty())
+    {
+      clientService.setMetronomeSamples(accentSample.isNotEmpty() ? juce::File(accentSample) : juce::File(),
+                                        normalSample.isNotEmpty() ? juce::File(normalSample) : juce::File());
+    }
   }
 }
 
@@ -414,6 +563,15 @@ void NinjamNextAudioProcessor::saveMetronomeSetting(bool enabled)
   }
 }
 
+void NinjamNextAudioProcessor::saveAlignmentModeSetting(NinjamClientService::AlignmentMode mode)
+{
+  if (auto* settings = appProperties.getUserSettings())
+  {
+    settings->setValue("alignmentMode", static_cast<int>(mode));
+    settings->saveIfNeeded();
+  }
+}
+
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
   return new NinjamNextAudioProcessor();
@@ -40,6 +40,8 @@ public:
   NinjamClientService::MonitorMode getMonitorMode() const;
   void setMetronomeEnabled(bool enabled);
   bool getMetronomeEnabled() const;
+  void setAlignmentMode(NinjamClientService::AlignmentMode mode);
+  NinjamClientService::AlignmentMode getAlignmentMode() const;
 
   void setUserChannelMute(int userIdx, int channelIdx, bool mute);
   void setUserChannelSolo(int userIdx, int channelIdx, bool solo);
@@ -53,7 +55,12 @@ private:
   void loadCredentialsFromSettings();
   void saveMonitorModeSetting(NinjamClientService::MonitorMode mode);
   void saveMetronomeSetting(bool enabled);
+  void saveAlignmentModeSetting(NinjamClientService::AlignmentMode mode);
   NinjamClientService::TransportState buildTransportState(int numSamples);
+  std::vector<NinjamClientService::LocalSend> buildLocalSends();
+  std::vector<int> buildStemOutputs() const;
+  int getTalkbackBusIndex();
+  int findTalkbackChannel();
 
   juce::ApplicationProperties appProperties;
   NinjamClientService clientService;
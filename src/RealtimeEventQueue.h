@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-capacity multi-producer / single-consumer queue for small POD events.
+// Producers (audio thread, network callbacks) never allocate or block; when
+// the queue is full the event is dropped and counted. The consumer drains it
+// on the message thread.
+template <typename Event, size_t Capacity>
+class RealtimeEventQueue
+{
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  RealtimeEventQueue() noexcept
+  {
+    for (size_t i = 0; i < Capacity; ++i)
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  bool tryPush(const Event& event) noexcept
+  {
+    auto pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+
+    for (;;)
+    {
+      cell = &cells[pos & (Capacity - 1)];
+      const auto seq = cell->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+      if (diff == 0)
+      {
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+      {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      else
+      {
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->event = event;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Single consumer only.
+  bool tryPop(Event& event) noexcept
+  {
+    auto& cell = cells[dequeuePos & (Capacity - 1)];
+    const auto seq = cell.sequence.load(std::memory_order_acquire);
+    if (static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(dequeuePos + 1) < 0)
+      return false;
+
+    event = cell.event;
+    cell.sequence.store(dequeuePos + Capacity, std::memory_order_release);
+    ++dequeuePos;
+    return true;
+  }
+
+  uint32_t takeDroppedCount() noexcept { return dropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence { 0 };
+    Event event {};
+  };
+
+  std::array<Cell, Capacity> cells;
+  std::atomic<size_t> enqueuePos { 0 };
+  size_t dequeuePos = 0;
+  std::atomic<uint32_t> dropped { 0 };
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <cmath>
+
+// Beat math for the host-locked sample clock, a 64-bit count of samples
+// since the last anchor. Kept apart from the service so it can be tested.
+namespace SampleClock
+{
+// Beat phase within a bpi cycle after `samples` at bpmMilli / 1000 BPM:
+// samples * bpmMilli / (60000 * sampleRate) beats, reduced modulo the cycle
+// in integers so the result is exact however long the clock has run.
+inline double cyclePhaseBeats(juce::int64 samples, juce::int64 bpmMilli, int sampleRateHz, int bpi)
+{
+  const juce::int64 unitsPerBeat = 60000 * static_cast<juce::int64>(sampleRateHz);
+  const juce::int64 unitsPerCycle = unitsPerBeat * bpi;
+  const juce::int64 wrapped = ((samples % unitsPerCycle) + unitsPerCycle) % unitsPerCycle;
+  const juce::int64 units = (wrapped * bpmMilli) % unitsPerCycle;
+  return static_cast<double>(units) / static_cast<double>(unitsPerBeat);
+}
+
+// The host-locked sync clock: a count of session samples since the clock
+// started, and an anchor the DAW phase is predicted from with
+// cyclePhaseBeats, so nothing accumulates in floating point. The host's
+// reported position only re-anchors the prediction, on a tempo change or
+// when it strays by more than the tolerance (a loop, or host rounding);
+// that leaves the session position alone. Only a seek restarts the clock.
+class HostClock
+{
+public:
+  struct Block
+  {
+    double phaseBeats = 0.0;        // DAW phase within the bpi cycle
+    juce::int64 sessionSamples = 0; // session position at the block start
+    bool restarted = false;         // the clock started over on this block
+    bool reanchored = false;        // the prediction jumped to the host
+  };
+
+  // hostBeats is the host's position in beats (PPQ, or time at the session
+  // tempo when the host has no musical clock).
+  Block advance(double hostBeats, double bpm, int sampleRateHz, int bpi, int numSamples,
+                bool seek, double toleranceSamples) noexcept
+  {
+    const double bpiD = static_cast<double>(bpi);
+    double hostPhase = std::fmod(hostBeats, bpiD);
+    if (hostPhase < 0.0)
+      hostPhase += bpiD;
+    const auto bpmMilli = static_cast<juce::int64>(std::llround(bpm * 1000.0));
+    const double samplesPerBeat = 60.0 * static_cast<double>(sampleRateHz) / bpm;
+
+    Block block;
+    block.phaseBeats = hostPhase;
+    if (!valid || seek)
+    {
+      valid = true;
+      samples = std::llround(hostPhase * samplesPerBeat);
+      setAnchor(hostPhase, bpmMilli);
+      block.restarted = true;
+    }
+    else
+    {
+      double predictedBeat = anchorBeat + cyclePhaseBeats(samples - anchorSamples, bpmMilli, sampleRateHz, bpi);
+      if (predictedBeat >= bpiD)
+        predictedBeat -= bpiD;
+
+      double driftBeats = hostPhase - predictedBeat;
+      if (driftBeats > 0.5 * bpiD) driftBeats -= bpiD;
+      if (driftBeats < -0.5 * bpiD) driftBeats += bpiD;
+
+      if (bpmMilli != anchorBpmMilli || std::abs(driftBeats) * samplesPerBeat > toleranceSamples)
+      {
+        setAnchor(hostPhase, bpmMilli);
+        block.reanchored = true;
+      }
+      else
+      {
+        block.phaseBeats = predictedBeat;
+      }
+    }
+
+    block.sessionSamples = samples;
+    samples += numSamples;
+    return block;
+  }
+
+  // The next block restarts the clock from the host position.
+  void invalidate() noexcept { valid = false; }
+
+  void reset() noexcept { *this = HostClock(); }
+
+private:
+  void setAnchor(double beat, juce::int64 bpmMilli) noexcept
+  {
+    anchorSamples = samples;
+    anchorBeat = beat;
+    anchorBpmMilli = bpmMilli;
+  }
+
+  bool valid = false;
+  juce::int64 samples = 0;
+  juce::int64 anchorSamples = 0;
+  double anchorBeat = 0.0;
+  juce::int64 anchorBpmMilli = 0;
+};
+}
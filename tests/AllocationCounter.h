@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// The test executable replaces the global operator new so realtime paths
+// can assert they never allocate. Counts are per thread.
+namespace AllocationCounter
+{
+int64_t getThreadAllocations() noexcept;
+}
@@ -0,0 +1,737 @@
+#include <JuceHeader.h>
+#include "AudioKernels.h"
+#include "Benchmark.h"
+#include "IntervalRing.h"
+
+#include <limits>
+#include <vector>
+
+namespace
+{
+int wrapIndex(int pos, int len)
+{
+  return ((pos % len) + len) % len;
+}
+
+// The per-sample ring copy forEachRingSpan replaced: two modulo
+// operations per sample per channel.
+void moduloRingCopy(float* dst, int dstPos, int dstLen, const float* src, int srcPos, int srcLen, int numSamples)
+{
+  for (int i = 0; i < numSamples; ++i)
+    dst[wrapIndex(dstPos + i, dstLen)] = src[wrapIndex(srcPos + i, srcLen)];
+}
+
+void spanRingCopy(float* dst, int dstPos, int dstLen, const float* src, int srcPos, int srcLen, int numSamples)
+{
+  AudioKernels::forEachRingSpan(dstPos, dstLen, srcPos, srcLen, numSamples, [&](int dstStart, int srcStart, int spanLen)
+  {
+    juce::FloatVectorOperations::copy(dst + dstStart, src + srcStart, spanLen);
+  });
+}
+}
+
+class RingSpanTests : public juce::UnitTest
+{
+public:
+  RingSpanTests() : juce::UnitTest("AudioKernels ring spans", "Realtime") {}
+
+  void runTest() override
+  {
+    beginTest("Spans match a per-sample modulo copy for any positions and lengths");
+    {
+      auto& random = getRandom();
+      bool matched = true;
+      bool spansValid = true;
+      for (int trial = 0; trial < 2000; ++trial)
+      {
+        const int dstLen = 1 + random.nextInt(700);
+        const int srcLen = 1 + random.nextInt(700);
+        const int numSamples = random.nextInt(juce::jmin(dstLen, srcLen) + 1);
+        const int dstPos = random.nextInt(4 * dstLen) - 2 * dstLen;
+        const int srcPos = random.nextInt(4 * srcLen) - 2 * srcLen;
+
+        std::vector<float> src(static_cast<size_t>(srcLen));
+        for (size_t i = 0; i < src.size(); ++i)
+          src[i] = static_cast<float>(i) + 1.0f;
+
+        std::vector<float> expected(static_cast<size_t>(dstLen), 0.0f);
+        std::vector<float> actual(static_cast<size_t>(dstLen), 0.0f);
+        moduloRingCopy(expected.data(), dstPos, dstLen, src.data(), srcPos, srcLen, numSamples);
+
+        int spans = 0;
+        AudioKernels::forEachRingSpan(dstPos, dstLen, srcPos, srcLen, numSamples, [&](int dstStart, int srcStart, int spanLen)
+        {
+          ++spans;
+          spansValid = spansValid && spanLen > 0 && dstStart + spanLen <= dstLen && srcStart + spanLen <= srcLen;
+          juce::FloatVectorOperations::copy(actual.data() + dstStart, src.data() + srcStart, spanLen);
+        });
+
+        spansValid = spansValid && spans <= 3;
+        matched = matched && expected == actual;
+      }
+      expect(matched, "span copy differs from the modulo reference");
+      expect(spansValid, "a span was empty, out of bounds, or there were more than three");
+    }
+
+    beginTest("Empty blocks touch nothing, even against zero-length buffers");
+    {
+      int spans = 0;
+      AudioKernels::forEachRingSpan(5, 0, 7, 0, 0, [&](int, int, int) { ++spans; });
+      AudioKernels::forEachRingSpan(0, 16, 3, 0, 0, [&](int, int, int) { ++spans; });
+      expectEquals(spans, 0);
+
+      // The host buffer of a 0-sample block is empty; the ring keeps its contents.
+      IntervalRing ring;
+      ring.allocate(2, 64, false);
+      ring.setLength(64);
+      juce::AudioBuffer<float> full(2, 64);
+      for (int ch = 0; ch < 2; ++ch)
+        juce::FloatVectorOperations::fill(full.getWritePointer(ch), 0.5f, 64);
+      ring.writeFrom(full, 0, 64, 0, 2, 64);
+      juce::AudioBuffer<float> empty(2, 0);
+      ring.writeFrom(empty, 0, 0, 10, 2, 0);
+      expectEquals(ring.getFloatPointer(1)[10], 0.5f);
+
+      std::vector<float> left(1, 1.0f), right(1, 1.0f);
+      float* host[2] = { left.data(), right.data() };
+      const float* ringChannels[2] = { ring.getFloatPointer(0), ring.getFloatPointer(1) };
+      AudioKernels::mixRing<2, false>(host, ringChannels, 10, 64, 0, 1.0f);
+      AudioKernels::mixRing<2, true>(host, ringChannels, 10, 64, 0, 1.0f);
+      expectEquals(left[0], 1.0f);
+      expectEquals(right[0], 1.0f);
+    }
+
+    beginTest("Fused gain: mixRing copy and add match the reference");
+    {
+      constexpr int ringLen = 1000;
+      constexpr int numSamples = 300;
+      std::vector<float> ringLeft(ringLen), ringRight(ringLen);
+      for (int i = 0; i < ringLen; ++i)
+      {
+        ringLeft[static_cast<size_t>(i)] = static_cast<float>(i);
+        ringRight[static_cast<size_t>(i)] = -static_cast<float>(i);
+      }
+
+      std::vector<float> left(numSamples, 1.0f), right(numSamples, 1.0f);
+      float* host[2] = { left.data(), right.data() };
+      const float* ring[2] = { ringLeft.data(), ringRight.data() };
+
+      AudioKernels::mixRing<2, false>(host, ring, 850, ringLen, numSamples, 0.5f);
+      expectEquals(left[0], 425.0f);
+      expectEquals(left[150], 0.0f);
+      expectEquals(right[299], -0.5f * 149.0f);
+
+      AudioKernels::mixRing<2, true>(host, ring, 850, ringLen, numSamples, 2.0f);
+      expectEquals(left[0], 425.0f + 1700.0f);
+      expectEquals(right[299], -0.5f * 149.0f - 2.0f * 149.0f);
+    }
+
+    beginTest("Benchmark: span copy vs per-sample modulo copy, 16 to 4096 samples");
+    {
+      constexpr int ringLen = 383999; // 8 s at 48 kHz, minus one: blocks keep landing on the wrap
+      std::vector<float> ring(ringLen, 0.5f);
+      std::vector<float> block(4096);
+
+      for (int blockSize = 16; blockSize <= 4096; blockSize *= 2)
+      {
+        int pos = ringLen - blockSize / 2;
+        const int runs = 2000000 / blockSize;
+        const auto modulo = Benchmark::nanosecondsPerRun(runs, [&]
+        {
+          moduloRingCopy(block.data(), 0, blockSize, ring.data(), pos, ringLen, blockSize);
+          pos = (pos + blockSize) % ringLen;
+          Benchmark::consume(block.data(), blockSize);
+        });
+        const auto spans = Benchmark::nanosecondsPerRun(runs, [&]
+        {
+          spanRingCopy(block.data(), 0, blockSize, ring.data(), pos, ringLen, blockSize);
+          pos = (pos + blockSize) % ringLen;
+          Benchmark::consume(block.data(), blockSize);
+        });
+
+        Benchmark::logTimings(*this, juce::String(blockSize) + " samples",
+                              { { "modulo", modulo / blockSize }, { "spans", spans / blockSize } });
+      }
+    }
+  }
+};
+
+static RingSpanTests ringSpanTests;
+
+namespace
+{
+constexpr int kPathBlockSize = 256;
+constexpr int kPathRingLen = 48000;
+constexpr float kPathLocalGain = 0.7f;
+constexpr float kPathRemoteGain = 0.8f;
+
+// VectorOps that counts the samples it touches, plus the copies and peak
+// scans of the staged path. A path's passes then come from the operations
+// that actually ran: one pass is every channel of the block once.
+struct CountingOps
+{
+  static inline int64_t samples = 0;
+
+  static void multiply(float* dst, float gain, int numSamples) noexcept
+  {
+    samples += numSamples;
+    AudioKernels::VectorOps::multiply(dst, gain, numSamples);
+  }
+
+  static void copyWithMultiply(float* dst, const float* src, float gain, int numSamples) noexcept
+  {
+    samples += numSamples;
+    AudioKernels::VectorOps::copyWithMultiply(dst, src, gain, numSamples);
+  }
+
+  static void addWithMultiply(float* dst, const float* src, float gain, int numSamples) noexcept
+  {
+    samples += numSamples;
+    AudioKernels::VectorOps::addWithMultiply(dst, src, gain, numSamples);
+  }
+
+  static void copy(float* dst, const float* src, int numSamples) noexcept
+  {
+    samples += numSamples;
+    juce::FloatVectorOperations::copy(dst, src, numSamples);
+  }
+
+  static void add(float* dst, const float* src, int numSamples) noexcept
+  {
+    samples += numSamples;
+    juce::FloatVectorOperations::add(dst, src, numSamples);
+  }
+
+  static void clear(float* dst, int numSamples) noexcept
+  {
+    samples += numSamples;
+    juce::FloatVectorOperations::clear(dst, numSamples);
+  }
+
+  // NinjamClientService::measurePeak over both channels.
+  static float peak(const juce::AudioBuffer<float>& buffer, int numSamples) noexcept
+  {
+    float result = 0.0f;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+      samples += numSamples;
+      result = juce::jmax(result, buffer.getMagnitude(ch, 0, numSamples));
+    }
+    return result;
+  }
+};
+
+template <int Mode>
+constexpr AudioKernels::OutputKernel countingKernel(bool readRing)
+{
+  return readRing ? &AudioKernels::writeOutput<2, true, Mode, CountingOps>
+                  : &AudioKernels::writeOutput<2, false, Mode, CountingOps>;
+}
+
+AudioKernels::OutputKernel selectCountingKernel(bool readRing, int mode)
+{
+  switch (mode)
+  {
+    case AudioKernels::monitorIncomingOnly: return countingKernel<AudioKernels::monitorIncomingOnly>(readRing);
+    case AudioKernels::monitorAddLocal:     return countingKernel<AudioKernels::monitorAddLocal>(readRing);
+    default:                                return countingKernel<AudioKernels::monitorListenLocal>(readRing);
+  }
+}
+
+juce::AudioBuffer<float> makePathInput()
+{
+  juce::AudioBuffer<float> input(2, kPathBlockSize);
+  for (int ch = 0; ch < 2; ++ch)
+    for (int i = 0; i < kPathBlockSize; ++i)
+      input.getWritePointer(ch)[i] = 0.3f * std::sin(0.05f * static_cast<float>(i + 7 * ch));
+  return input;
+}
+
+struct SignalPath
+{
+  SignalPath()
+  {
+    for (auto* buffer : { &inputScratch, &txMonitorScratch, &outputScratch })
+      buffer->setSize(2, kPathBlockSize);
+    ring.setSize(2, kPathRingLen);
+
+    for (int ch = 0; ch < 2; ++ch)
+      for (int i = 0; i < kPathRingLen; ++i)
+        ring.getWritePointer(ch)[i] = 0.2f * std::cos(0.013f * static_cast<float>(i + 11 * ch));
+  }
+
+  // Runs one block and returns the passes it made.
+  template <typename PathFn>
+  int countPasses(PathFn&& path)
+  {
+    block.reset();
+    CountingOps::samples = 0;
+    path();
+    return static_cast<int>(CountingOps::samples / (2 * kPathBlockSize));
+  }
+
+  Benchmark::HostBlock block { makePathInput() };
+  juce::AudioBuffer<float>& host = block.host;
+  juce::AudioBuffer<float> inputScratch, txMonitorScratch, outputScratch, ring;
+  int ringPos = kPathRingLen - kPathBlockSize / 2;
+  float outputPeak = 0.0f;
+};
+
+// The block before the copy-elimination pass, with AudioProc and the ring
+// write left out (both paths share them). Disconnected, it still staged
+// and mixed everything, only without the ring read.
+void runStagedPath(SignalPath& path, int mode, bool connected)
+{
+  const bool addLocal = mode == AudioKernels::monitorAddLocal;
+  const bool listenLocal = mode == AudioKernels::monitorListenLocal;
+  const auto forEachChannel = [](auto&& fn) { for (int ch = 0; ch < 2; ++ch) fn(ch); };
+
+  forEachChannel([&](int ch) { CountingOps::copy(path.inputScratch.getWritePointer(ch), path.host.getReadPointer(ch), kPathBlockSize); });
+
+  if (addLocal || listenLocal)
+  {
+    forEachChannel([&](int ch) { CountingOps::copy(path.txMonitorScratch.getWritePointer(ch), path.inputScratch.getReadPointer(ch), kPathBlockSize); });
+    forEachChannel([&](int ch) { CountingOps::multiply(path.txMonitorScratch.getWritePointer(ch), kPathLocalGain, kPathBlockSize); });
+  }
+
+  const float sendPeak = CountingOps::peak(path.inputScratch, kPathBlockSize);
+
+  forEachChannel([&](int ch) { CountingOps::clear(path.outputScratch.getWritePointer(ch), kPathBlockSize); });
+  if (connected)
+  {
+    AudioKernels::forEachRingSpan(0, kPathBlockSize, path.ringPos, kPathRingLen, kPathBlockSize, [&](int dstStart, int srcStart, int spanLen)
+    {
+      forEachChannel([&](int ch) { CountingOps::copy(path.outputScratch.getWritePointer(ch, dstStart), path.ring.getReadPointer(ch, srcStart), spanLen); });
+    });
+  }
+
+  if (listenLocal)
+  {
+    forEachChannel([&](int ch) { CountingOps::copy(path.host.getWritePointer(ch), path.txMonitorScratch.getReadPointer(ch), kPathBlockSize); });
+  }
+  else
+  {
+    forEachChannel([&](int ch) { CountingOps::copy(path.host.getWritePointer(ch), path.outputScratch.getReadPointer(ch), kPathBlockSize); });
+    forEachChannel([&](int ch) { CountingOps::multiply(path.host.getWritePointer(ch), kPathRemoteGain, kPathBlockSize); });
+    if (addLocal)
+      forEachChannel([&](int ch) { CountingOps::add(path.host.getWritePointer(ch), path.txMonitorScratch.getReadPointer(ch), kPathBlockSize); });
+  }
+
+  path.outputPeak = CountingOps::peak(path.host, kPathBlockSize);
+  juce::ignoreUnused(sendPeak);
+}
+
+// The connected host-locked block as processSubBlock runs it: one send
+// peak, the specialised kernel, and an output peak except in ListenLocal,
+// which reuses the send peak.
+void runKernelPath(SignalPath& path, AudioKernels::OutputKernel kernel, int mode)
+{
+  const float sendPeak = CountingOps::peak(path.host, kPathBlockSize);
+
+  AudioKernels::OutputArgs args;
+  args.host = path.host.getArrayOfWritePointers();
+  args.ring = path.ring.getArrayOfReadPointers();
+  args.ringPos = path.ringPos;
+  args.ringLen = kPathRingLen;
+  args.numSamples = kPathBlockSize;
+  args.localGain = kPathLocalGain;
+  args.remoteGain = kPathRemoteGain;
+  kernel(args);
+
+  path.outputPeak = mode == AudioKernels::monitorListenLocal ? sendPeak * kPathLocalGain
+                                                             : CountingOps::peak(path.host, kPathBlockSize);
+}
+
+// The disconnected block as processSubBlock runs it: the send peak, then
+// the host buffer is left alone except for ListenLocal's local gain.
+void runDisconnectedPath(SignalPath& path, AudioKernels::OutputKernel kernel, int mode)
+{
+  const float sendPeak = CountingOps::peak(path.host, kPathBlockSize);
+  path.outputPeak = sendPeak;
+  if (mode == AudioKernels::monitorListenLocal)
+  {
+    AudioKernels::OutputArgs args;
+    args.host = path.host.getArrayOfWritePointers();
+    args.numSamples = kPathBlockSize;
+    args.localGain = kPathLocalGain;
+    kernel(args);
+    path.outputPeak = sendPeak * kPathLocalGain;
+  }
+}
+
+const char* monitorModeName(int mode)
+{
+  switch (mode)
+  {
+    case AudioKernels::monitorIncomingOnly: return "IncomingOnly";
+    case AudioKernels::monitorAddLocal:     return "AddLocal";
+    default:                                return "ListenLocal";
+  }
+}
+}
+
+class MonitorModePathTests : public juce::UnitTest
+{
+public:
+  MonitorModePathTests() : juce::UnitTest("AudioKernels monitor modes", "Realtime") {}
+
+  void runTest() override
+  {
+    for (int mode = AudioKernels::monitorIncomingOnly; mode <= AudioKernels::monitorListenLocal; ++mode)
+    {
+      beginTest(juce::String("Connected kernel path matches the staged path: ") + monitorModeName(mode));
+      testConnected(mode);
+
+      beginTest(juce::String("Disconnected path passes the host buffer through: ") + monitorModeName(mode));
+      testDisconnected(mode);
+    }
+  }
+
+private:
+  // Passes per block: the send peak, one for local gain (AddLocal and
+  // ListenLocal), one for the fused remote gain and ring read (not in
+  // ListenLocal), and the output peak (not in ListenLocal).
+  static int expectedKernelPasses(int mode)
+  {
+    return mode == AudioKernels::monitorIncomingOnly ? 3 : (mode == AudioKernels::monitorAddLocal ? 4 : 2);
+  }
+
+  void testConnected(int mode)
+  {
+    const auto kernel = selectCountingKernel(true, mode);
+    SignalPath staged, fused;
+    const int stagedPasses = staged.countPasses([&] { runStagedPath(staged, mode, true); });
+    const int kernelPasses = fused.countPasses([&] { runKernelPath(fused, kernel, mode); });
+
+    expectLessOrEqual(worstDifference(staged.host, fused.host), 1.0e-6f, "output differs");
+    expectWithinAbsoluteError(fused.outputPeak, staged.outputPeak, 1.0e-6f, "output meter differs");
+    expectEquals(kernelPasses, expectedKernelPasses(mode), "kernel passes per block");
+    expectLessThan(kernelPasses, stagedPasses, "the kernel path should make fewer passes");
+
+    // The timed runs use the uncounted kernel the service selects.
+    const auto serviceKernel = AudioKernels::selectOutputKernel(2, true, mode);
+    constexpr int runs = 20000;
+    const auto stagedNs = Benchmark::nanosecondsPerSample(staged.block, kPathBlockSize, runs, [&] { runStagedPath(staged, mode, true); });
+    const auto kernelNs = Benchmark::nanosecondsPerSample(fused.block, kPathBlockSize, runs, [&] { runKernelPath(fused, serviceKernel, mode); });
+    Benchmark::logTimings(*this, juce::String("Connected ") + monitorModeName(mode),
+                          { { "staged (" + juce::String(stagedPasses) + " passes)", stagedNs },
+                            { "kernel (" + juce::String(kernelPasses) + " passes)", kernelNs } });
+  }
+
+  void testDisconnected(int mode)
+  {
+    const auto kernel = selectCountingKernel(false, mode);
+    SignalPath staged, passThrough;
+    const int stagedPasses = staged.countPasses([&] { runStagedPath(staged, mode, false); });
+    const int passThroughPasses = passThrough.countPasses([&] { runDisconnectedPath(passThrough, kernel, mode); });
+
+    // Only ListenLocal touches the buffer (local gain); the other modes
+    // hear the input unchanged.
+    const bool listenLocal = mode == AudioKernels::monitorListenLocal;
+    juce::AudioBuffer<float> expected(passThrough.block.input);
+    if (listenLocal)
+      for (int ch = 0; ch < 2; ++ch)
+        juce::FloatVectorOperations::multiply(expected.getWritePointer(ch), kPathLocalGain, kPathBlockSize);
+    expectLessOrEqual(worstDifference(expected, passThrough.host), 1.0e-6f, "output differs from the input");
+    expectEquals(passThroughPasses, listenLocal ? 2 : 1, "the send peak, plus local gain for ListenLocal");
+    expectLessThan(passThroughPasses, stagedPasses, "the pass-through should make fewer passes");
+
+    const auto serviceKernel = AudioKernels::selectOutputKernel(2, false, mode);
+    constexpr int runs = 20000;
+    const auto stagedNs = Benchmark::nanosecondsPerSample(staged.block, kPathBlockSize, runs, [&] { runStagedPath(staged, mode, false); });
+    const auto passThroughNs = Benchmark::nanosecondsPerSample(passThrough.block, kPathBlockSize, runs, [&]
+    {
+      runDisconnectedPath(passThrough, serviceKernel, mode);
+    });
+    Benchmark::logTimings(*this, juce::String("Disconnected ") + monitorModeName(mode),
+                          { { "staged (" + juce::String(stagedPasses) + " passes)", stagedNs },
+                            { "pass-through (" + juce::String(passThroughPasses) + " passes)", passThroughNs } });
+  }
+
+  static float worstDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+  {
+    float worst = 0.0f;
+    for (int ch = 0; ch < 2; ++ch)
+      for (int i = 0; i < kPathBlockSize; ++i)
+        worst = juce::jmax(worst, std::abs(a.getReadPointer(ch)[i] - b.getReadPointer(ch)[i]));
+    return worst;
+  }
+};
+
+static MonitorModePathTests monitorModePathTests;
+
+namespace
+{
+// Runtime-branching equivalent of writeOutput, one sample at a time.
+void referenceOutput(const AudioKernels::OutputArgs& args, int numChannels, bool readRing, int mode)
+{
+  const bool scaleLocal = mode == AudioKernels::monitorAddLocal || mode == AudioKernels::monitorListenLocal;
+  for (int ch = 0; ch < numChannels; ++ch)
+  {
+    for (int i = 0; i < args.numSamples; ++i)
+    {
+      float& out = args.host[ch][i];
+      if (scaleLocal)
+        out *= args.localGain;
+      if (mode == AudioKernels::monitorListenLocal)
+        continue;
+
+      const float remote = readRing ? args.ring[ch][wrapIndex(args.ringPos + i, args.ringLen)] : args.remote[ch][i];
+      out = mode == AudioKernels::monitorAddLocal ? out + remote * args.remoteGain : remote * args.remoteGain;
+    }
+  }
+}
+}
+
+class OutputKernelMatrixTests : public juce::UnitTest
+{
+public:
+  OutputKernelMatrixTests() : juce::UnitTest("AudioKernels specialisations", "Realtime") {}
+
+  void runTest() override
+  {
+    constexpr int blockSize = 256;
+    constexpr int ringLen = 48000;
+
+    juce::AudioBuffer<float> input(2, blockSize), remote(2, blockSize), ring(2, ringLen);
+    auto& random = getRandom();
+    for (int ch = 0; ch < 2; ++ch)
+    {
+      for (int i = 0; i < blockSize; ++i)
+      {
+        input.getWritePointer(ch)[i] = random.nextFloat() - 0.5f;
+        remote.getWritePointer(ch)[i] = random.nextFloat() - 0.5f;
+      }
+      for (int i = 0; i < ringLen; ++i)
+        ring.getWritePointer(ch)[i] = random.nextFloat() - 0.5f;
+    }
+
+    Benchmark::HostBlock expected(input), actual(input);
+
+    const auto makeArgs = [&](juce::AudioBuffer<float>& host)
+    {
+      AudioKernels::OutputArgs args;
+      args.host = host.getArrayOfWritePointers();
+      args.remote = remote.getArrayOfReadPointers();
+      args.ring = ring.getArrayOfReadPointers();
+      args.ringPos = ringLen - blockSize / 3;
+      args.ringLen = ringLen;
+      args.numSamples = blockSize;
+      args.localGain = 0.6f;
+      args.remoteGain = 1.3f;
+      return args;
+    };
+
+    for (int numChannels = 1; numChannels <= 2; ++numChannels)
+    {
+      for (const bool readRing : { false, true })
+      {
+        for (int mode = AudioKernels::monitorIncomingOnly; mode <= AudioKernels::monitorListenLocal; ++mode)
+        {
+          const juce::String label = juce::String(numChannels) + " ch, " + (readRing ? "ring" : "direct") + ", "
+                                  + monitorModeName(mode);
+          beginTest("Specialisation matches the reference: " + label);
+
+          const auto kernel = AudioKernels::selectOutputKernel(numChannels, readRing, mode);
+          const auto args = makeArgs(actual.host);
+          const auto referenceArgs = makeArgs(expected.host);
+          expected.reset();
+          actual.reset();
+          referenceOutput(referenceArgs, numChannels, readRing, mode);
+          kernel(args);
+
+          float worstError = 0.0f;
+          for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+              worstError = juce::jmax(worstError, std::abs(expected.host.getReadPointer(ch)[i] - actual.host.getReadPointer(ch)[i]));
+          expectLessOrEqual(worstError, 1.0e-6f);
+
+          const auto kernelNs = Benchmark::nanosecondsPerSample(actual, blockSize, 20000, [&] { kernel(args); });
+          const auto referenceNs = Benchmark::nanosecondsPerSample(expected, blockSize, 20000, [&]
+          {
+            referenceOutput(referenceArgs, numChannels, readRing, mode);
+          });
+          Benchmark::logTimings(*this, label, { { "kernel", kernelNs / numChannels },
+                                                { "branching reference", referenceNs / numChannels } });
+        }
+      }
+    }
+  }
+};
+
+static OutputKernelMatrixTests outputKernelMatrixTests;
+
+namespace
+{
+constexpr int kSubBlockIntervalLen = 48000;
+constexpr int kMaxSubBlockSamples = 1024; // NinjamClientService's cap
+
+// A stand-in for NJClient's interval position, advanced by each sub-block
+// as processSubBlock advances the real one.
+struct ServerClock
+{
+  int pos = 0;
+  int len = 0;
+
+  void get(int& intervalPos, int& intervalLen) const
+  {
+    intervalPos = pos;
+    intervalLen = len;
+  }
+
+  void advance(int numSamples)
+  {
+    if (len > 0)
+      pos = (pos + numSamples) % len;
+  }
+};
+}
+
+class SubBlockSplitTests : public juce::UnitTest
+{
+public:
+  SubBlockSplitTests() : juce::UnitTest("AudioKernels sub-blocks", "Realtime") {}
+
+  void runTest() override
+  {
+    beginTest("Sub-blocks tile the host block without crossing an interval boundary");
+    testSplitCoverage();
+
+    beginTest("Benchmark: sub-block overhead for 64 to 512 sample host blocks");
+    benchmarkTypicalBlocks();
+
+    beginTest("Benchmark: offline-sized host blocks, whole vs split");
+    benchmarkOfflineBlocks();
+  }
+
+private:
+  void testSplitCoverage()
+  {
+    auto& random = getRandom();
+    int badPieces = 0;
+    int gaps = 0;
+    for (int trial = 0; trial < 5000; ++trial)
+    {
+      const int maxSubBlocks[] = { 64, 256, kMaxSubBlockSamples };
+      const int maxSubBlock = maxSubBlocks[random.nextInt(3)];
+      const int numSamples = maxSubBlock + 1 + random.nextInt(20000);
+
+      // Intervals shorter than a host block, ordinary ones, and an unknown
+      // position (not connected), which only caps the length.
+      const int intervalLens[] = { 0, 100 + random.nextInt(900), 1000 + random.nextInt(400000) };
+      ServerClock server;
+      server.len = intervalLens[random.nextInt(3)];
+      server.pos = server.len > 0 ? random.nextInt(server.len) : 0;
+
+      int covered = 0;
+      const auto getPosition = [&](int& pos, int& len) { server.get(pos, len); };
+      AudioKernels::forEachSubBlock(numSamples, maxSubBlock, getPosition, [&](int offset, int len)
+      {
+        if (offset != covered)
+          ++gaps;
+        if (len <= 0 || len > maxSubBlock || (server.len > 0 && server.pos + len > server.len))
+          ++badPieces;
+        if (server.len == 0 && len != juce::jmin(maxSubBlock, numSamples - offset))
+          ++badPieces;
+        covered = offset + len;
+        server.advance(len);
+      });
+
+      if (covered != numSamples)
+        ++gaps;
+    }
+    expectEquals(gaps, 0, "sub-blocks overlap, leave gaps or miss the end of the host block");
+    expectEquals(badPieces, 0, "a sub-block was empty, too long or crossed an interval boundary");
+  }
+
+  // A sub-block's work as the host-locked path does it: read the output
+  // ring over the host block, adding local.
+  struct Workload
+  {
+    explicit Workload(int maxBlockSize)
+      : block(2, maxBlockSize, 0.25f), ring(2, kSubBlockIntervalLen)
+    {
+      for (int ch = 0; ch < 2; ++ch)
+        juce::FloatVectorOperations::fill(ring.getWritePointer(ch), 0.5f, kSubBlockIntervalLen);
+      server.len = kSubBlockIntervalLen;
+    }
+
+    void processSubBlock(juce::AudioBuffer<float>& subBlock)
+    {
+      AudioKernels::OutputArgs args;
+      args.host = subBlock.getArrayOfWritePointers();
+      args.ring = ring.getArrayOfReadPointers();
+      args.ringPos = server.pos;
+      args.ringLen = kSubBlockIntervalLen;
+      args.numSamples = subBlock.getNumSamples();
+      args.localGain = 0.7f;
+      args.remoteGain = 0.8f;
+      kernel(args);
+      server.advance(subBlock.getNumSamples());
+    }
+
+    // processAudioBlock's shape: whole blocks up to the cap, split above it.
+    void processAudioBlock(int numSamples, int maxSubBlock)
+    {
+      juce::AudioBuffer<float> whole(block.host.getArrayOfWritePointers(), 2, 0, numSamples);
+      if (numSamples <= maxSubBlock)
+      {
+        processSubBlock(whole);
+        return;
+      }
+
+      const auto getPosition = [this](int& pos, int& len) { server.get(pos, len); };
+      AudioKernels::forEachSubBlock(numSamples, maxSubBlock, getPosition, [&](int offset, int len)
+      {
+        juce::AudioBuffer<float> subBlock(block.host.getArrayOfWritePointers(), 2, offset, len);
+        processSubBlock(subBlock);
+      });
+    }
+
+    Benchmark::HostBlock block;
+    juce::AudioBuffer<float> ring;
+    ServerClock server;
+    const AudioKernels::OutputKernel kernel = AudioKernels::selectOutputKernel(2, true, AudioKernels::monitorAddLocal);
+  };
+
+  void benchmarkTypicalBlocks()
+  {
+    // A host announcing blocks up to the cap never splits; forcing 64-sample
+    // sub-blocks shows what splitting itself costs per sample.
+    for (int blockSize = 64; blockSize <= 512; blockSize *= 2)
+    {
+      Workload work(blockSize);
+      const int runs = 4000000 / blockSize;
+      const auto timed = [&](int maxSubBlock)
+      {
+        return Benchmark::nanosecondsPerSample(work.block, blockSize, runs, [&] { work.processAudioBlock(blockSize, maxSubBlock); });
+      };
+
+      Benchmark::logTimings(*this, juce::String(blockSize) + " samples",
+                            { { "whole", timed(std::numeric_limits<int>::max()) },
+                              { "through the sub-block path", timed(kMaxSubBlockSamples) },
+                              { "split into 64", timed(64) } });
+    }
+  }
+
+  void benchmarkOfflineBlocks()
+  {
+    // Kept below the interval: a whole block longer than that cannot read
+    // the ring in one pass, which is why the service splits them.
+    for (const int blockSize : { 4096, 16384, 32768 })
+    {
+      Workload work(blockSize);
+      const int runs = 8000000 / blockSize;
+      const auto timed = [&](int maxSubBlock)
+      {
+        return Benchmark::nanosecondsPerSample(work.block, blockSize, runs, [&] { work.processAudioBlock(blockSize, maxSubBlock); });
+      };
+
+      Benchmark::logTimings(*this, juce::String(blockSize) + " samples",
+                            { { "whole", timed(std::numeric_limits<int>::max()) },
+                              { "split into " + juce::String(kMaxSubBlockSamples), timed(kMaxSubBlockSamples) } });
+    }
+  }
+};
+
+static SubBlockSplitTests subBlockSplitTests;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <initializer_list>
+
+// Timing helpers shared by the benchmark cases. Results are logged rather
+// than asserted so the suite stays stable on loaded CI machines.
+namespace Benchmark
+{
+template <typename Fn>
+double nanosecondsPerRun(int runs, Fn&& fn)
+{
+  fn(); // warm caches and branch predictors
+  const auto start = juce::Time::getHighResolutionTicks();
+  for (int i = 0; i < runs; ++i)
+    fn();
+  const auto ticks = juce::Time::getHighResolutionTicks() - start;
+  return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / static_cast<double>(runs);
+}
+
+// Keeps the optimiser from discarding a benchmarked result.
+inline void consume(const float* data, int numSamples)
+{
+  static volatile float sink = 0.0f;
+  if (numSamples > 0)
+    sink = sink + data[numSamples - 1];
+}
+
+// A host buffer processed in place, restored from a fixed input before
+// every run so repeated gain cannot decay it into denormals. Every variant
+// timed against it pays the same restoring copy.
+struct HostBlock
+{
+  explicit HostBlock(const juce::AudioBuffer<float>& source)
+    : input(source), host(source.getNumChannels(), source.getNumSamples())
+  {
+    reset();
+  }
+
+  HostBlock(int numChannels, int numSamples, float value)
+    : input(numChannels, numSamples), host(numChannels, numSamples)
+  {
+    for (int ch = 0; ch < numChannels; ++ch)
+      juce::FloatVectorOperations::fill(input.getWritePointer(ch), value, numSamples);
+    reset();
+  }
+
+  void reset() { reset(input.getNumSamples()); }
+
+  void reset(int numSamples)
+  {
+    for (int ch = 0; ch < input.getNumChannels(); ++ch)
+      juce::FloatVectorOperations::copy(host.getWritePointer(ch), input.getReadPointer(ch), numSamples);
+  }
+
+  juce::AudioBuffer<float> input, host;
+};
+
+// Nanoseconds per sample of fn processing the first numSamples of block,
+// reset before each run.
+template <typename Fn>
+double nanosecondsPerSample(HostBlock& block, int numSamples, int runs, Fn&& fn)
+{
+  return nanosecondsPerRun(runs, [&]
+  {
+    block.reset(numSamples);
+    fn();
+    consume(block.host.getReadPointer(0), numSamples);
+  }) / static_cast<double>(numSamples);
+}
+
+struct Timing
+{
+  juce::String name;
+  double nanosecondsPerSample;
+};
+
+// Logs one line per comparison: "<label>: <name> <n> ns/sample, ...".
+inline void logTimings(juce::UnitTest& test, const juce::String& label, std::initializer_list<Timing> timings)
+{
+  juce::StringArray parts;
+  for (const auto& timing : timings)
+    parts.add(timing.name + " " + juce::String(timing.nanosecondsPerSample, 3) + " ns/sample");
+  test.logMessage(label + ": " + parts.joinIntoString(", "));
+}
+}
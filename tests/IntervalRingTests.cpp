@@ -0,0 +1,265 @@
+#include <JuceHeader.h>
+#include "AllocationCounter.h"
+#include "IntervalRing.h"
+#include "PhaseRings.h"
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+constexpr int kSampleRate = 48000;
+constexpr int kBlockSize = 256;
+constexpr int kChannels = 2;
+constexpr int kStemChannels = 2;
+constexpr int kLimitMinBpm = 60;
+constexpr int kLimitMaxBpi = 32;
+
+int intervalSamples(int bpm, int bpi)
+{
+  return static_cast<int>(static_cast<juce::int64>(kSampleRate) * 60 * bpi / bpm);
+}
+}
+
+// Ring geometry as the audio thread drives it: storage is sized once for
+// the BPM/BPI limits, and server tempo votes only move the logical length.
+// The ring path runs through PhaseRings, the same stages processSubBlock
+// calls.
+class IntervalRingTests : public juce::UnitTest
+{
+public:
+  IntervalRingTests() : juce::UnitTest("IntervalRing", "Realtime") {}
+
+  void runTest() override
+  {
+    for (const bool compact : { false, true })
+    {
+      const juce::String storage = compact ? " (16-bit)" : " (float)";
+
+      beginTest("BPM/BPI changes mid-session never allocate on the audio thread" + storage);
+      testTempoChangesDoNotAllocate(compact);
+
+      beginTest("After an interval change, reads are silent until the new geometry is written" + storage);
+      testReadAfterLengthChange(compact);
+
+      beginTest("clearUnwritten silences exactly the unwritten part of the read span" + storage);
+      testClearUnwrittenMatchesPerSample(compact);
+
+      beginTest("Round trip error stays within half a storage step" + storage);
+      testRoundTripError(compact);
+    }
+  }
+
+private:
+  void testTempoChangesDoNotAllocate(bool compact)
+  {
+    // prepare(): the only allocations. The phase ring carries the main mix
+    // and one stem pair, as processSubBlock sizes it.
+    constexpr int ringOutputs = kChannels + kStemChannels;
+    const int capacity = intervalSamples(kLimitMinBpm, kLimitMaxBpi);
+    IntervalRing inputRing, phaseRing;
+    inputRing.allocate(kChannels, capacity, compact);
+    phaseRing.allocate(ringOutputs, capacity, compact);
+    juce::AudioBuffer<float> host(ringOutputs, kBlockSize);
+    juce::AudioBuffer<float> inputScratch(kChannels, kBlockSize);
+    juce::AudioBuffer<float> outputScratch(ringOutputs, kBlockSize);
+    juce::AudioBuffer<float> unpackScratch(ringOutputs, kBlockSize);
+
+    struct Vote { int bpm; int bpi; };
+    const Vote votes[] = { { 120, 16 }, { 90, 32 }, { 140, 8 }, { 60, 32 }, { 97, 7 }, { 120, 16 }, { 180, 4 } };
+
+    const auto allocationsBefore = AllocationCounter::getThreadAllocations();
+    int serverPos = 0;
+    double dawPhase = 1.0 / 3.0;
+    bool lengthsStayedInCapacity = true;
+    for (const auto& vote : votes)
+    {
+      const int intervalLen = intervalSamples(vote.bpm, vote.bpi);
+      lengthsStayedInCapacity = lengthsStayedInCapacity && intervalLen <= capacity;
+
+      // A few intervals per vote, block by block as processSubBlock runs them.
+      for (int block = 0; block < 3 * intervalLen / kBlockSize; ++block)
+      {
+        for (int ch = 0; ch < ringOutputs; ++ch)
+          juce::FloatVectorOperations::fill(host.getWritePointer(ch), 0.25f * static_cast<float>(ch + 1), kBlockSize);
+
+        const int writePos = PhaseRings::beatToPosition(dawPhase, vote.bpi, intervalLen);
+        PhaseRings::remapInput(inputRing, inputScratch, host, kChannels, kBlockSize, writePos, serverPos, intervalLen);
+
+        // NJClient's part: render the remote mix for this block.
+        for (int ch = 0; ch < ringOutputs; ++ch)
+          outputScratch.copyFrom(ch, 0, inputScratch, ch % kChannels, 0, kBlockSize);
+        serverPos = (serverPos + kBlockSize) % intervalLen;
+
+        PhaseRings::writeOutput(phaseRing, outputScratch, ringOutputs, kBlockSize, serverPos, intervalLen);
+        const float* ringChannels[ringOutputs] = {};
+        const int readPos = PhaseRings::beatToPosition(dawPhase, vote.bpi, intervalLen);
+        const auto ringRead = PhaseRings::readOutput(phaseRing, unpackScratch, ringChannels, ringOutputs, kBlockSize, readPos);
+
+        float* hostChannels[kChannels] = { host.getWritePointer(0), host.getWritePointer(1) };
+        const float* ringMain[kChannels] = { ringChannels[0], ringChannels[1] };
+        AudioKernels::OutputArgs args;
+        args.host = hostChannels;
+        args.ring = ringMain;
+        args.ringPos = ringRead.pos;
+        args.ringLen = ringRead.len;
+        args.numSamples = kBlockSize;
+        args.localGain = 1.0f;
+        args.remoteGain = 1.0f;
+        AudioKernels::selectOutputKernel(kChannels, true, AudioKernels::monitorAddLocal)(args);
+
+        float* stemHost[kStemChannels] = { host.getWritePointer(kChannels), host.getWritePointer(kChannels + 1) };
+        const float* stemRing[kStemChannels] = { ringChannels[kChannels], ringChannels[kChannels + 1] };
+        AudioKernels::mixRing<kStemChannels, false>(stemHost, stemRing, ringRead.pos, ringRead.len, kBlockSize, 1.0f);
+
+        dawPhase += static_cast<double>(vote.bpi) * kBlockSize / intervalLen;
+      }
+    }
+    const auto allocations = AllocationCounter::getThreadAllocations() - allocationsBefore;
+
+    expect(lengthsStayedInCapacity, "a vote exceeded the preallocated capacity");
+    expectEquals(static_cast<int>(allocations), 0, "the audio path allocated");
+
+    // By the last vote's final interval both rings are written through, so
+    // the main bus is local plus the remote copy and the stem is remote only.
+    const float tolerance = compact ? 1.0e-3f : 0.0f;
+    expectWithinAbsoluteError(host.getReadPointer(1)[kBlockSize - 1], 0.5f + 0.5f, tolerance);
+    expectWithinAbsoluteError(host.getReadPointer(kChannels + 1)[kBlockSize - 1], 0.5f, tolerance);
+  }
+
+  // setLength clears nothing, so the storage still holds the old geometry.
+  // Whatever the new interval exposes must read as silence until it has
+  // been written again, and new writes must read back.
+  void testReadAfterLengthChange(bool compact)
+  {
+    IntervalRing ring;
+    ring.allocate(1, 4096, compact);
+    juce::AudioBuffer<float> unpackScratch(1, kBlockSize);
+
+    juce::AudioBuffer<float> stale(1, 4096);
+    juce::FloatVectorOperations::fill(stale.getWritePointer(0), 0.5f, 4096);
+    ring.setLength(4096);
+    ring.writeFrom(stale, 0, 4096, 0, 1, 4096);
+    ring.markWritten(0, 4096);
+
+    // Shrink, then grow past the old length's stale tail.
+    ring.setLength(3000);
+    ring.setLength(4000);
+    expectEquals(ring.getFilledSamples(), 0, "a new geometry restarts the fill arc");
+
+    const auto readPeak = [&](int pos)
+    {
+      const float* channels[1] = {};
+      const auto read = PhaseRings::readOutput(ring, unpackScratch, channels, 1, kBlockSize, pos);
+      float peak = 0.0f;
+      for (int i = 0; i < kBlockSize; ++i)
+        peak = juce::jmax(peak, std::abs(channels[0][(read.pos + i) % read.len]));
+      return peak;
+    };
+
+    float stalePeak = 0.0f;
+    for (int pos = 0; pos < 4000; pos += kBlockSize)
+      stalePeak = juce::jmax(stalePeak, readPeak(pos));
+    expectEquals(stalePeak, 0.0f, "stale audio from the old geometry was read");
+
+    juce::AudioBuffer<float> block(1, kBlockSize);
+    juce::FloatVectorOperations::fill(block.getWritePointer(0), 0.25f, kBlockSize);
+    PhaseRings::writeOutput(ring, block, 1, kBlockSize, 3900 + kBlockSize, 4000);
+    expectWithinAbsoluteError(readPeak(3900), 0.25f, compact ? 1.0e-3f : 0.0f);
+    expectEquals(readPeak(3900 + kBlockSize), 0.0f, "the span after the write was not silent");
+  }
+
+  // Checks the span arithmetic against a per-sample walk of the ring over
+  // random geometries, including read spans that wrap the ring end and
+  // re-enter the unwritten arc.
+  void testClearUnwrittenMatchesPerSample(bool compact)
+  {
+    auto& random = getRandom();
+    IntervalRing ring;
+    ring.allocate(kChannels, 1024, compact);
+    juce::AudioBuffer<float> contents(kChannels, 1024);
+    for (int ch = 0; ch < kChannels; ++ch)
+      juce::FloatVectorOperations::fill(contents.getWritePointer(ch), 0.5f, 1024);
+
+    int mismatches = 0;
+    for (int trial = 0; trial < 2000; ++trial)
+    {
+      const int length = 1 + random.nextInt(1024);
+      ring.setLength(length);
+      ring.writeFrom(contents, 0, 1024, 0, kChannels, length);
+
+      const int fillStart = random.nextInt(length);
+      const int filled = random.nextInt(length);
+      if (filled > 0)
+        ring.markWritten(fillStart, filled);
+
+      const int pos = random.nextInt(length);
+      const int numSamples = 1 + random.nextInt(length);
+      ring.clearUnwritten(pos, numSamples, kChannels);
+
+      juce::AudioBuffer<float> readBack(kChannels, length);
+      ring.readInto(readBack, 0, length, 0, kChannels, length);
+      for (int i = 0; i < length; ++i)
+      {
+        const bool inRead = (i - pos + length) % length < numSamples;
+        const bool written = (i - fillStart + length) % length < filled;
+        const float expected = inRead && !written ? 0.0f : 0.5f;
+        for (int ch = 0; ch < kChannels; ++ch)
+          if (std::abs(readBack.getReadPointer(ch)[i] - expected) > 1.0e-3f)
+            ++mismatches;
+      }
+    }
+    expectEquals(mismatches, 0);
+  }
+
+  // Compact storage keeps 12 dB of headroom in int16, so one step is
+  // 4 / 32767 and rounding to nearest costs at most half of it. Anything
+  // past +/-4 clips to full scale of the stored range; float is exact.
+  void testRoundTripError(bool compact)
+  {
+    constexpr int numSamples = 65536;
+    constexpr float headroom = 4.0f;
+    const float halfStep = 0.5f * headroom / 32767.0f;
+
+    auto& random = getRandom();
+    std::vector<float> source(numSamples), readBack(numSamples);
+    for (int i = 0; i < numSamples; ++i)
+    {
+      // Mostly within the headroom, including quiet material; every
+      // eighth sample overshoots it.
+      const float scale = i % 8 == 7 ? 3.0f * headroom : (i % 8 == 6 ? 1.0e-3f : headroom);
+      source[static_cast<size_t>(i)] = (2.0f * random.nextFloat() - 1.0f) * scale;
+    }
+
+    IntervalRing ring;
+    ring.allocate(1, numSamples, compact);
+    ring.setLength(numSamples);
+    ring.write(0, 0, source.data(), numSamples);
+    ring.read(0, 0, readBack.data(), numSamples);
+
+    float worstInRange = 0.0f;
+    float worstClipped = 0.0f;
+    for (int i = 0; i < numSamples; ++i)
+    {
+      const float in = source[static_cast<size_t>(i)];
+      const float out = readBack[static_cast<size_t>(i)];
+      if (!compact || std::abs(in) <= headroom)
+        worstInRange = juce::jmax(worstInRange, std::abs(out - in));
+      else
+        worstClipped = juce::jmax(worstClipped, std::abs(out - std::copysign(headroom, in)));
+    }
+
+    if (compact)
+    {
+      // A float ulp of slack on top of the rounding bound.
+      expectLessOrEqual(worstInRange, halfStep * 1.0001f);
+      expectLessOrEqual(worstClipped, 1.0e-6f);
+    }
+    else
+    {
+      expectEquals(worstInRange, 0.0f);
+    }
+  }
+};
+
+static IntervalRingTests intervalRingTests;
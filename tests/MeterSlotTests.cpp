@@ -0,0 +1,133 @@
+#include <JuceHeader.h>
+#include "MeterSlot.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr int kBlocks = 20000;
+constexpr int kBlockSize = 256;
+constexpr int kReaders = 2;
+constexpr int kSnapshotLogLines = 300;
+
+float meterValueForBlock(int block)
+{
+  return static_cast<float>(block % 1000) / 1000.0f;
+}
+}
+
+// Unit test of MeterSlot on its own; it does not run the service. A writer
+// thread stands in for the audio thread and publishes one peak per block,
+// while reader threads poll the slot and copy a snapshot-sized payload
+// under a stand-in for the service lock. The assertions cover the slot's
+// ordering and values only. The writer's worst-case publish time is logged,
+// not asserted, next to a baseline writer that takes the lock every block.
+class MeterSlotTests : public juce::UnitTest
+{
+public:
+  MeterSlotTests() : juce::UnitTest("MeterSlot", "Realtime") {}
+
+  void runTest() override
+  {
+    beginTest("Slot readers see published values in order while another thread holds a lock");
+    {
+      const auto result = runStress(false);
+      expect(result.sequencesMonotonic, "a reader saw the meter sequence go backwards");
+      expect(result.valuesInRange, "a reader saw a value that was never published");
+      expectEquals(static_cast<int>(result.finalSequence), kBlocks);
+      expectEquals(result.finalValue, meterValueForBlock(kBlocks - 1));
+      logMessage("Worst publish, lock-free slot: " + juce::String(result.worstBlockMs, 3) + " ms");
+    }
+
+    beginTest("Baseline: a slot writer that takes the lock every block");
+    {
+      const auto result = runStress(true);
+      logMessage("Worst publish, locked slot:    " + juce::String(result.worstBlockMs, 3) + " ms");
+    }
+  }
+
+private:
+  struct StressResult
+  {
+    double worstBlockMs = 0.0;
+    bool sequencesMonotonic = true;
+    bool valuesInRange = true;
+    uint32_t finalSequence = 0;
+    float finalValue = 0.0f;
+  };
+
+  static StressResult runStress(bool writerTakesLock)
+  {
+    MeterSlot slot;
+    juce::CriticalSection snapshotLock;
+    juce::StringArray logLines;
+    for (int i = 0; i < kSnapshotLogLines; ++i)
+      logLines.add("log line " + juce::String(i));
+
+    std::atomic<bool> writerDone { false };
+    std::atomic<bool> monotonic { true };
+    std::atomic<bool> inRange { true };
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < kReaders; ++r)
+    {
+      readers.emplace_back([&]
+      {
+        uint32_t lastSequence = 0;
+        while (!writerDone.load())
+        {
+          const auto sequence = slot.getSequence();
+          if (sequence < lastSequence)
+            monotonic = false;
+          lastSequence = sequence;
+
+          const float value = slot.read();
+          if (value < 0.0f || value >= 1.0f)
+            inRange = false;
+
+          const juce::ScopedLock scopedLock(snapshotLock);
+          juce::StringArray copy(logLines);
+          juce::ignoreUnused(copy);
+        }
+      });
+    }
+
+    std::vector<float> block(kBlockSize);
+    juce::int64 worstTicks = 0;
+    for (int b = 0; b < kBlocks; ++b)
+    {
+      const auto start = juce::Time::getHighResolutionTicks();
+      for (int i = 0; i < kBlockSize; ++i)
+        block[static_cast<size_t>(i)] = meterValueForBlock(b) * static_cast<float>(i % 2);
+
+      const float peak = juce::FloatVectorOperations::findMaximum(block.data(), kBlockSize);
+      if (writerTakesLock)
+      {
+        const juce::ScopedLock scopedLock(snapshotLock);
+        slot.publish(peak);
+      }
+      else
+      {
+        slot.publish(peak);
+      }
+
+      worstTicks = juce::jmax(worstTicks, juce::Time::getHighResolutionTicks() - start);
+    }
+
+    writerDone = true;
+    for (auto& reader : readers)
+      reader.join();
+
+    StressResult result;
+    result.worstBlockMs = juce::Time::highResolutionTicksToSeconds(worstTicks) * 1000.0;
+    result.sequencesMonotonic = monotonic.load();
+    result.valuesInRange = inRange.load();
+    result.finalSequence = slot.getSequence();
+    result.finalValue = slot.read();
+    return result;
+  }
+};
+
+static MeterSlotTests meterSlotTests;
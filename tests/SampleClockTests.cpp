@@ -0,0 +1,191 @@
+#include <JuceHeader.h>
+#include "SampleClock.h"
+
+#include <cmath>
+#include <iterator>
+
+namespace
+{
+constexpr juce::int64 kSecondsPerDay = 24 * 60 * 60;
+constexpr int kBlockSizes[] = { 64, 441, 512, 1000 };
+
+// Room tempo votes over the day: { BPM * 1000, BPI }.
+struct Vote
+{
+  juce::int64 bpmMilli;
+  int bpi;
+};
+constexpr Vote kVotes[] = { { 120000, 16 }, { 97500, 32 }, { 133333, 8 }, { 60000, 4 },
+                            { 180000, 7 }, { 90000, 256 }, { 142857, 12 }, { 120000, 16 } };
+}
+
+// Steps the sample clock as the audio thread does, a block at a time, for a
+// simulated day at the common host rates. The reference reduces
+// block * bpmMilli into the cycle once per block, so it never holds more
+// than one cycle of units; cyclePhaseBeats must agree with it exactly.
+class SampleClockTests : public juce::UnitTest
+{
+public:
+  SampleClockTests() : juce::UnitTest("SampleClock", "Realtime") {}
+
+  void runTest() override
+  {
+    for (const int sampleRate : { 44100, 48000 })
+    {
+      const juce::String rate = " at " + juce::String(sampleRate) + " Hz";
+
+      beginTest("24 hours of blocks across tempo changes keep the exact phase" + rate);
+      testDayOfBlocks(sampleRate);
+
+      beginTest("Whole intervals land on phase zero" + rate);
+      testWholeIntervals(sampleRate);
+
+      beginTest("A day of jittery host PPQ re-anchors only on tempo changes and loops" + rate);
+      testHostClockDay(sampleRate);
+    }
+  }
+
+private:
+  void testDayOfBlocks(int sampleRate)
+  {
+    const juce::int64 daySamples = kSecondsPerDay * sampleRate;
+    const juce::int64 samplesPerVote = daySamples / static_cast<juce::int64>(std::size(kVotes));
+    const juce::int64 unitsPerBeat = 60000 * static_cast<juce::int64>(sampleRate);
+
+    juce::int64 mismatches = 0;
+    double worstFloatDrift = 0.0;
+    juce::int64 done = 0;
+    size_t blockIndex = 0;
+    for (const auto& vote : kVotes)
+    {
+      // A vote re-anchors the clock, as a tempo change does in the service.
+      const juce::int64 unitsPerCycle = unitsPerBeat * vote.bpi;
+      const double beatsPerSample = static_cast<double>(vote.bpmMilli) / static_cast<double>(unitsPerBeat);
+      juce::int64 elapsed = 0;
+      juce::int64 referenceUnits = 0;
+      double floatPhase = 0.0;
+
+      while (elapsed < samplesPerVote)
+      {
+        const int block = kBlockSizes[blockIndex++ % std::size(kBlockSizes)];
+        elapsed += block;
+        referenceUnits = (referenceUnits + block * vote.bpmMilli) % unitsPerCycle;
+        floatPhase = std::fmod(floatPhase + block * beatsPerSample, static_cast<double>(vote.bpi));
+
+        const double phase = SampleClock::cyclePhaseBeats(elapsed, vote.bpmMilli, sampleRate, vote.bpi);
+        const double expected = static_cast<double>(referenceUnits) / static_cast<double>(unitsPerBeat);
+        if (phase != expected)
+          ++mismatches;
+
+        double drift = std::abs(floatPhase - expected);
+        drift = juce::jmin(drift, static_cast<double>(vote.bpi) - drift);
+        worstFloatDrift = juce::jmax(worstFloatDrift, drift);
+      }
+      done += elapsed;
+    }
+
+    expectGreaterOrEqual(done, daySamples);
+    expectEquals(static_cast<int>(mismatches), 0, "phase differs from the integer reference");
+    logMessage("Float accumulator over the same blocks drifted up to "
+               + juce::String(worstFloatDrift, 9) + " beats");
+  }
+
+  void testWholeIntervals(int sampleRate)
+  {
+    // Tempos whose interval is a whole number of samples at both rates.
+    for (const Vote vote : { Vote { 120000, 16 }, Vote { 60000, 4 }, Vote { 150000, 32 } })
+    {
+      const juce::int64 intervalSamples = static_cast<juce::int64>(sampleRate) * 60000 * vote.bpi / vote.bpmMilli;
+      const juce::int64 intervalsPerDay = kSecondsPerDay * sampleRate / intervalSamples;
+
+      int nonZero = 0;
+      for (juce::int64 k = 1; k <= intervalsPerDay; ++k)
+        if (SampleClock::cyclePhaseBeats(k * intervalSamples, vote.bpmMilli, sampleRate, vote.bpi) != 0.0)
+          ++nonZero;
+      expectEquals(nonZero, 0);
+
+      // A sample either side of a boundary a year in is one sample's worth
+      // of beats from zero, not rounding noise.
+      const juce::int64 yearBoundary = (365 * kSecondsPerDay * sampleRate / intervalSamples) * intervalSamples;
+      const double oneSample = static_cast<double>(vote.bpmMilli) / (60000.0 * sampleRate);
+      expectEquals(SampleClock::cyclePhaseBeats(yearBoundary, vote.bpmMilli, sampleRate, vote.bpi), 0.0);
+      expectWithinAbsoluteError(SampleClock::cyclePhaseBeats(yearBoundary + 1, vote.bpmMilli, sampleRate, vote.bpi),
+                                oneSample, 1.0e-15);
+      expectWithinAbsoluteError(SampleClock::cyclePhaseBeats(yearBoundary - 1, vote.bpmMilli, sampleRate, vote.bpi),
+                                static_cast<double>(vote.bpi) - oneSample, 1.0e-12);
+    }
+  }
+
+  // HostClock fed a day of host blocks as processSubBlock feeds it: PPQ
+  // from the host's tempo map with up to kJitterSamples of rounding error,
+  // a tempo change at every vote and a loop back in the middle of each.
+  // The DAW phase must stay within the jitter of the host's true phase
+  // without ever drifting, the session position must run on untouched, and
+  // only the tempo changes and loops may re-anchor.
+  void testHostClockDay(int sampleRate)
+  {
+    constexpr double kToleranceSamples = 1.0; // kHostClockToleranceSamples
+    constexpr double kJitterSamples = 0.45;
+    constexpr double kLoopBackBeats = 3.0;
+    const juce::int64 daySamples = kSecondsPerDay * sampleRate;
+    const juce::int64 samplesPerVote = daySamples / static_cast<juce::int64>(std::size(kVotes));
+
+    auto& random = getRandom();
+    SampleClock::HostClock clock;
+    double voteStartBeats = 0.0;
+    juce::int64 firstSessionSamples = 0;
+    juce::int64 done = 0;
+    size_t blockIndex = 0;
+    int restarts = 0;
+    int reanchors = 0;
+    juce::int64 sessionMismatches = 0;
+    double worstErrorSamples = 0.0;
+    for (const auto& vote : kVotes)
+    {
+      const double bpm = static_cast<double>(vote.bpmMilli) / 1000.0;
+      const double samplesPerBeat = 60.0 * sampleRate / bpm;
+      const double bpiD = static_cast<double>(vote.bpi);
+      double loopOffsetBeats = 0.0;
+      juce::int64 elapsed = 0;
+
+      while (elapsed < samplesPerVote)
+      {
+        if (loopOffsetBeats == 0.0 && elapsed >= samplesPerVote / 2)
+          loopOffsetBeats = -kLoopBackBeats;
+
+        const int block = kBlockSizes[blockIndex++ % std::size(kBlockSizes)];
+        const double hostBeats = voteStartBeats + loopOffsetBeats + static_cast<double>(elapsed) / samplesPerBeat;
+        const double jitterBeats = (2.0 * random.nextFloat() - 1.0) * kJitterSamples / samplesPerBeat;
+        const auto result = clock.advance(hostBeats + jitterBeats, bpm, sampleRate, vote.bpi, block, false, kToleranceSamples);
+
+        if (result.restarted)
+        {
+          ++restarts;
+          firstSessionSamples = result.sessionSamples - done - elapsed;
+        }
+        reanchors += result.reanchored ? 1 : 0;
+        if (result.sessionSamples != firstSessionSamples + done + elapsed)
+          ++sessionMismatches;
+
+        const double truePhase = std::fmod(hostBeats + bpiD, bpiD);
+        double errorBeats = std::abs(result.phaseBeats - truePhase);
+        errorBeats = juce::jmin(errorBeats, bpiD - errorBeats);
+        worstErrorSamples = juce::jmax(worstErrorSamples, errorBeats * samplesPerBeat);
+
+        elapsed += block;
+      }
+
+      voteStartBeats += loopOffsetBeats + static_cast<double>(elapsed) / samplesPerBeat;
+      done += elapsed;
+    }
+
+    const int votes = static_cast<int>(std::size(kVotes));
+    expectEquals(restarts, 1, "only the first block may restart the clock");
+    expectEquals(reanchors, (votes - 1) + votes, "one re-anchor per tempo change and per loop");
+    expectEquals(static_cast<int>(sessionMismatches), 0, "the session position was disturbed");
+    expectLessOrEqual(worstErrorSamples, kJitterSamples + 1.0e-3, "phase strayed from the host by more than its jitter");
+    logMessage("Worst phase error over the day: " + juce::String(worstErrorSamples, 3) + " samples");
+  }
+};
+
+static SampleClockTests sampleClockTests;
@@ -0,0 +1,16 @@
+#include <JuceHeader.h>
+
+// Runs every juce::UnitTest registered by the test sources. Exits non-zero
+// on any failure so CTest reports it.
+int main()
+{
+  juce::UnitTestRunner runner;
+  runner.setAssertOnFailure(false);
+  runner.runAllTests();
+
+  int failures = 0;
+  for (int i = 0; i < runner.getNumResults(); ++i)
+    failures += runner.getResult(i)->failures;
+
+  return failures > 0 ? 1 : 0;
+}